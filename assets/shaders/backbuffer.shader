@@ -1,24 +1,12 @@
 @vs
+#include "fullscreen.glsl"
+
 out vec2 uv;
 
 void main()
 {
-	vec4 vertices[4] = vec4[4](
-        vec4(-1, -1, 0, 1),
-        vec4( 1, -1, 0, 1),
-        vec4(-1,  1, 0, 1),
-        vec4( 1,  1, 0, 1)
-    );
-
-	vec2 uv_coord[4] = vec2[4](
-        vec2(0, 0),
-        vec2(1, 0),
-        vec2(0, 1),
-        vec2(1, 1)
-    );
-
-	uv = uv_coord[gl_VertexID];
-	gl_Position = vertices[gl_VertexID];
+	uv = fullscreen_uvs[gl_VertexID];
+	gl_Position = fullscreen_vertices[gl_VertexID];
 }
 
 @fs
@@ -0,0 +1,13 @@
+const vec4 fullscreen_vertices[4] = vec4[4](
+    vec4(-1, -1, 0, 1),
+    vec4( 1, -1, 0, 1),
+    vec4(-1,  1, 0, 1),
+    vec4( 1,  1, 0, 1)
+);
+
+const vec2 fullscreen_uvs[4] = vec2[4](
+    vec2(0, 0),
+    vec2(1, 0),
+    vec2(0, 1),
+    vec2(1, 1)
+);
@@ -1,3 +1,5 @@
+@variant fill
+
 @vs
 layout(location = 0) in vec3 a_pos;
 layout(location = 1) in vec2 a_uv;
@@ -36,10 +38,12 @@ void main()
     vec4 b = fill;
 
     float blend = b.a;
-    float alpha = 0.0;
 
-    if (tint.a == 0.0) alpha = b.a;
-    else alpha = a.a;
+#ifdef FILL
+    float alpha = b.a;
+#else
+    float alpha = a.a;
+#endif
 
     color = vec4(mix(a, b, blend).rgb, alpha);
 }
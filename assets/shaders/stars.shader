@@ -1,14 +1,9 @@
 @vs
+#include "fullscreen.glsl"
+
 void main()
 {
-	vec4 vertices[4] = vec4[4](
-        vec4(-1, -1, 0, 1),
-        vec4( 1, -1, 0, 1),
-        vec4(-1,  1, 0, 1),
-        vec4( 1,  1, 0, 1)
-    );
-
-	gl_Position = vertices[gl_VertexID];
+	gl_Position = fullscreen_vertices[gl_VertexID];
 }
 
 @fs
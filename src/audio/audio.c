@@ -10,22 +10,315 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define CUTE_SOUND_FORCE_SDL
 #define CUTE_SOUND_IMPLEMENTATION
+
+// cute_sound mixes four samples at a time with sse2, the web
+// build gets it from emscripten's simd128 translation headers,
+// arm has no neon path and mixes scalar, a port is out of scope
+// until tools/mixer shows the mix matters there (make mixer)
+#if !defined(__SSE2__) && !defined(_M_X64) && !(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
 #define CUTE_SOUND_SCALAR_MODE
+#endif
+
 #define CUTE_SOUND_SDL_H "SDL.h"
+#include "SDL.h"
+#include "audio/headless.h"
 #include "cute_sound.h"
 
 #include "audio/audio.h"
+#include "audio/sound.h"
+
+#include "platform/trace.h"
+
+// the thread wakes a few times within
+// even the smallest buffer's duration
+#define AUDIO_DELAY (2)
+
+// a buffer grows as soon as the mixer falls behind, it
+// shrinks after a quiet minute but never back to a size
+// that underran, so a slow machine settles and stays
+#define AUDIO_SHRINK_AFTER (60.0)
+
+// rates a device could plausibly open,
+// anything else is a typo in the override
+#define AUDIO_RATE_MIN (8000)
+#define AUDIO_RATE_MAX (192000)
+
+static audio_desc_t  audio_desc;
+static audio_stats_t audio_stats;
+static int           audio_floor;
+static double        audio_clean;
+static bool          audio_reopened;
+static int           audio_rendered;
 
-void audio_init(void)
+static void audio_open(int buffer)
 {
-    cs_error_t error = cs_init(NULL, 44100, 1024, NULL);
+    cs_error_t error = cs_init(NULL, (unsigned)audio_desc.sample_rate, buffer, NULL);
     assert(error == CUTE_SOUND_ERROR_NONE);
+
+    audio_stats.sample_rate = audio_desc.sample_rate;
+    audio_stats.buffer      = buffer;
+    audio_stats.latency     = 1000.0f * (float)buffer / (float)audio_desc.sample_rate;
+}
+
+static void audio_resize(int buffer)
+{
+#ifdef DEBUG
+    printf("[AUDIO] Buffer %d -> %d samples\n", audio_stats.buffer, buffer);
+#endif
+
+    cs_shutdown();
+    audio_open(buffer);
+    sound_restart();
+
+    audio_reopened = true;
+}
+
+// the device drains the buffer on its own, so a gap between
+// two mixes longer than the buffer lasts means it ran dry
+static void audio_adapt(double elapsed, double duration)
+{
+    // the gap over a reopen is the device
+    // starting up, not the mixer falling behind
+    if (audio_reopened)
+    {
+        audio_reopened = false;
+        return;
+    }
+
+    if (elapsed > duration)
+    {
+        ++audio_stats.underruns;
+
+        audio_clean = 0.0;
+        audio_floor = audio_stats.buffer * 2;
+
+        if (audio_desc.adaptive && audio_stats.buffer < audio_desc.buffer_max) audio_resize(audio_stats.buffer * 2);
+
+        return;
+    }
+
+    audio_clean += elapsed;
+
+    if (!audio_desc.adaptive || audio_clean < AUDIO_SHRINK_AFTER) return;
+
+    audio_clean = 0.0;
+
+    int buffer = audio_stats.buffer / 2;
+
+    if (buffer >= audio_desc.buffer_min && buffer >= audio_floor) audio_resize(buffer);
+}
+
+static void audio_mix(double elapsed)
+{
+    double duration = (double)audio_stats.buffer / (double)audio_desc.sample_rate;
+
+    sound_lock();
+
+    sound_process(elapsed);
+    cs_update((float)elapsed);
+
+    audio_adapt(elapsed, duration);
+
+    sound_unlock();
+}
+
+#ifndef __EMSCRIPTEN__
+static SDL_Thread*  audio_thread;
+static SDL_atomic_t audio_running;
+
+// gameplay only queues commands, everything touching
+// the mixer happens here so hitches can't starve it
+static int audio_run(void* data)
+{
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    uint64_t last      = SDL_GetPerformanceCounter();
+
+    while (SDL_AtomicGet(&audio_running))
+    {
+        uint64_t now = SDL_GetPerformanceCounter();
+
+        audio_mix((double)(now - last) / (double)frequency);
+
+        last = now;
+
+        SDL_Delay(AUDIO_DELAY);
+    }
+
+    return 0;
+}
+#endif
+
+static int audio_get_env(const char* name, int value)
+{
+    const char* env = getenv(name);
+
+    return env && atoi(env) > 0 ? atoi(env) : value;
+}
+
+void audio_init(audio_desc_t desc)
+{
+    TRACE_BEGIN("audio_init");
+
+    assert(desc.buffer_min <= desc.buffer && desc.buffer <= desc.buffer_max);
+
+    // the environment overrides the game's choice, to try a
+    // machine without a rebuild, release keeps its asserts
+    // so a bad value is turned away here instead
+    int rate   = audio_get_env("GAME_AUDIO_RATE", desc.sample_rate);
+    int buffer = audio_get_env("GAME_AUDIO_BUFFER", desc.buffer);
+
+    if (rate >= AUDIO_RATE_MIN && rate <= AUDIO_RATE_MAX) desc.sample_rate = rate;
+#ifdef DEBUG
+    else printf("[AUDIO] Ignoring GAME_AUDIO_RATE %d, outside %d-%d\n", rate, AUDIO_RATE_MIN, AUDIO_RATE_MAX);
+#endif
+
+    desc.buffer = buffer < desc.buffer_min ? desc.buffer_min : buffer > desc.buffer_max ? desc.buffer_max : buffer;
+
+#ifdef DEBUG
+    if (desc.buffer != buffer) printf("[AUDIO] Clamped GAME_AUDIO_BUFFER %d to %d\n", buffer, desc.buffer);
+#endif
+
+    audio_desc  = desc;
+    audio_stats = (audio_stats_t){0};
+    audio_floor = 0;
+    audio_clean = 0.0;
+
+    sound_init(desc.sample_rate);
+
+    // nothing plays offline, the dummy driver keeps sdl
+    // from looking for a device and the shim captures it
+    if (desc.headless)
+    {
+        SDL_SetHint(SDL_HINT_AUDIODRIVER, "dummy");
+        SDL_InitSubSystem(SDL_INIT_AUDIO);
+
+        headless_enable(true);
+
+        audio_rendered = 0;
+    }
+
+    audio_open(desc.buffer);
+
+    if (desc.headless)
+    {
+        TRACE_END();
+        return;
+    }
+
+#ifndef __EMSCRIPTEN__
+    SDL_AtomicSet(&audio_running, 1);
+
+    audio_thread = SDL_CreateThread(audio_run, "audio", NULL);
+
+    assert(audio_thread);
+#endif
+
+    TRACE_END();
 }
 
-void audio_shutdown(void) { cs_shutdown(); }
+void audio_stop(void)
+{
+#ifndef __EMSCRIPTEN__
+    if (audio_thread == NULL) return;
+
+    SDL_AtomicSet(&audio_running, 0);
+    SDL_WaitThread(audio_thread, NULL);
 
-void audio_update(float dt) { cs_update(dt); }
+    audio_thread = NULL;
+#endif
+}
+
+void audio_shutdown(void)
+{
+    audio_stop();
+
+    sound_shutdown();
+
+    cs_shutdown();
+
+    if (audio_desc.headless)
+    {
+        headless_enable(false);
+
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    }
+}
+
+void audio_update(float dt)
+{
+    if (audio_desc.headless) return;
+
+#ifdef __EMSCRIPTEN__
+    // without threads the frame mixes,
+    // as cute_sound did on its own
+    audio_mix(dt);
+#endif
+}
+
+audio_stats_t audio_get_stats(void)
+{
+    return audio_stats;
+}
+
+float* audio_get_samples(cs_audio_source_t* source, int channel)
+{
+    assert(channel < source->channel_count);
+    return (float*)source->channels[channel];
+}
+
+int audio_get_sample_count(cs_audio_source_t* source) { return source->sample_count; }
+
+bool audio_is_headless(void) { return audio_desc.headless; }
+
+uint64_t audio_voice_play(cs_audio_source_t* source, float volume, bool loop)
+{
+    cs_sound_params_t csparams = cs_sound_params_default();
+
+    csparams.volume = volume;
+    csparams.looped = loop;
+
+    return cs_play_sound(source, csparams).id;
+}
+
+bool audio_voice_is_active(uint64_t voice) { return cs_sound_is_active((cs_playing_sound_t){.id = voice}); }
+
+void audio_voice_stop(uint64_t voice) { cs_sound_stop((cs_playing_sound_t){.id = voice}); }
+
+void audio_voice_set_volume(uint64_t voice, float volume) { cs_sound_set_volume((cs_playing_sound_t){.id = voice}, volume); }
+
+void audio_voice_set_index(uint64_t voice, int index) { cs_sound_set_sample_index((cs_playing_sound_t){.id = voice}, index); }
+
+int audio_voice_get_index(uint64_t voice) { return cs_sound_get_sample_index((cs_playing_sound_t){.id = voice}); }
+
+// cute_sound mixes into its ring as it would for the device,
+// topping it up to the buffer on each update, so the pulls
+// are never bigger than that and each one finds it full
+void audio_render(int16_t* samples, int frames)
+{
+    assert(audio_desc.headless);
+
+    double rate = (double)audio_desc.sample_rate;
+
+    // the commands apply before this block, so
+    // the time passed is what the last one mixed
+    sound_process((double)audio_rendered / rate);
+
+    audio_rendered = frames;
+
+    for (int done = 0; done < frames;)
+    {
+        int chunk = frames - done < audio_stats.buffer ? frames - done : audio_stats.buffer;
+
+        cs_update((float)((double)chunk / rate));
+
+        headless_pull(samples + done * 2, chunk);
+
+        done += chunk;
+    }
+}
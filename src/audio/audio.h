@@ -11,16 +11,66 @@
 #ifndef AUDIO_AUDIO_H
 #define AUDIO_AUDIO_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
-    void audio_init(void);
+    typedef struct audio_desc_t
+    {
+        int  sample_rate;
+        int  buffer;  // samples mixed ahead, the latency
+        int  buffer_min;
+        int  buffer_max;
+        bool adaptive;
+        bool headless;  // no device is opened, the mix is pulled with render
+    } audio_desc_t;
+
+    typedef struct audio_stats_t
+    {
+        int      sample_rate;
+        int      buffer;
+        float    latency;  // in milliseconds
+        uint32_t underruns;
+    } audio_stats_t;
+
+    void audio_init(audio_desc_t desc);
     void audio_shutdown(void);
 
+    // joins the mixing thread ahead of shutdown, so the
+    // sounds can be unloaded with nothing playing them
+    void audio_stop(void);
+
     void audio_update(float dt);
 
+    // underruns count since init, buffer and
+    // latency follow the adaptive resizing
+    audio_stats_t audio_get_stats(void);
+
+    // cute_sound only defines its sources in the implementation
+    // compiled here, streams write their ring through this
+    typedef struct cs_audio_source_t cs_audio_source_t;
+
+    float* audio_get_samples(cs_audio_source_t* source, int channel);
+    int    audio_get_sample_count(cs_audio_source_t* source);
+
+    // thin over cute_sound's playing sounds, which
+    // are only declared in the implementation
+    uint64_t audio_voice_play(cs_audio_source_t* source, float volume, bool loop);
+    bool     audio_voice_is_active(uint64_t voice);
+    void     audio_voice_stop(uint64_t voice);
+    void     audio_voice_set_volume(uint64_t voice, float volume);
+    void     audio_voice_set_index(uint64_t voice, int index);
+    int      audio_voice_get_index(uint64_t voice);
+
+    // headless only, runs the queued commands then pulls frames
+    // of interleaved 16 bit stereo through cute_sound's mixer
+    bool audio_is_headless(void);
+    void audio_render(int16_t* samples, int frames);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,178 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   __  __   ______   ______    _____    __       ______   ______   ______     //
+//  /\ \_\ \ /\  ___\ /\  __ \  /\  __-. /\ \     /\  ___\ /\  ___\ /\  ___\    //
+//  \ \  __ \\ \  __\ \ \  __ \ \ \ \/\ \\ \ \____\ \  __\ \ \___  \\ \___  \   //
+//   \ \_\ \_\\ \_____\\ \_\ \_\ \ \____- \ \_____\\ \_____\\/\_____\\/\_____\  //
+//    \/_/\/_/ \/_____/ \/_/\/_/  \/____/  \/_____/ \/_____/ \/_____/ \/_____/  //
+//                                                                              //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// audio/headless.h
+
+#ifndef AUDIO_HEADLESS_H
+#define AUDIO_HEADLESS_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+// included before cute_sound's implementation, its calls to open
+// the device land here so an offline render or a benchmark pulls
+// the real mix without a device draining it on its own clock
+
+#define HEADLESS_DEVICE (1)
+
+static bool              headless_enabled;
+static SDL_AudioCallback headless_callback;
+static void*             headless_userdata;
+
+// whatever cute_sound queues when it pushes
+// instead of being called back, in bytes
+static uint8_t* headless_queue;
+static size_t   headless_queue_len;
+static size_t   headless_queue_cap;
+
+static inline void headless_enable(bool enabled)
+{
+    headless_enabled   = enabled;
+    headless_callback  = NULL;
+    headless_userdata  = NULL;
+    headless_queue_len = 0;
+}
+
+static inline void headless_capture(const SDL_AudioSpec* desired, SDL_AudioSpec* obtained)
+{
+    // the mix is written out as it comes,
+    // so the format has to be the one we expect
+    assert(desired->format == AUDIO_S16SYS && desired->channels == 2);
+
+    headless_callback = desired->callback;
+    headless_userdata = desired->userdata;
+
+    if (obtained) *obtained = *desired;
+}
+
+static inline SDL_AudioDeviceID headless_open_audio_device(const char* device, int iscapture, const SDL_AudioSpec* desired, SDL_AudioSpec* obtained, int allowed_changes)
+{
+    if (!headless_enabled) return SDL_OpenAudioDevice(device, iscapture, desired, obtained, allowed_changes);
+
+    headless_capture(desired, obtained);
+
+    return HEADLESS_DEVICE;
+}
+
+static inline int headless_open_audio(SDL_AudioSpec* desired, SDL_AudioSpec* obtained)
+{
+    if (!headless_enabled) return SDL_OpenAudio(desired, obtained);
+
+    headless_capture(desired, obtained);
+
+    return 0;
+}
+
+static inline void headless_pause_audio_device(SDL_AudioDeviceID device, int pause_on)
+{
+    if (!headless_enabled) SDL_PauseAudioDevice(device, pause_on);
+}
+
+static inline void headless_pause_audio(int pause_on)
+{
+    if (!headless_enabled) SDL_PauseAudio(pause_on);
+}
+
+static inline void headless_lock_audio_device(SDL_AudioDeviceID device)
+{
+    if (!headless_enabled) SDL_LockAudioDevice(device);
+}
+
+static inline void headless_unlock_audio_device(SDL_AudioDeviceID device)
+{
+    if (!headless_enabled) SDL_UnlockAudioDevice(device);
+}
+
+static inline void headless_lock_audio(void)
+{
+    if (!headless_enabled) SDL_LockAudio();
+}
+
+static inline void headless_unlock_audio(void)
+{
+    if (!headless_enabled) SDL_UnlockAudio();
+}
+
+static inline void headless_close_audio_device(SDL_AudioDeviceID device)
+{
+    if (!headless_enabled) SDL_CloseAudioDevice(device);
+}
+
+static inline void headless_close_audio(void)
+{
+    if (!headless_enabled) SDL_CloseAudio();
+}
+
+static inline int headless_queue_audio(SDL_AudioDeviceID device, const void* data, Uint32 len)
+{
+    if (!headless_enabled) return SDL_QueueAudio(device, data, len);
+
+    if (headless_queue_len + len > headless_queue_cap)
+    {
+        headless_queue_cap = (headless_queue_len + len) * 2;
+        headless_queue     = (uint8_t*)realloc(headless_queue, headless_queue_cap);
+
+        assert(headless_queue);
+    }
+
+    memcpy(headless_queue + headless_queue_len, data, len);
+
+    headless_queue_len += len;
+
+    return 0;
+}
+
+static inline Uint32 headless_get_queued_audio_size(SDL_AudioDeviceID device)
+{
+    if (!headless_enabled) return SDL_GetQueuedAudioSize(device);
+
+    return (Uint32)headless_queue_len;
+}
+
+// takes frames of interleaved stereo the way the device would,
+// from the callback or the queue, silence where nothing was mixed
+static inline void headless_pull(int16_t* samples, int frames)
+{
+    assert(headless_enabled);
+
+    size_t len = (size_t)frames * 2 * sizeof(int16_t);
+
+    if (headless_callback)
+    {
+        headless_callback(headless_userdata, (Uint8*)samples, (int)len);
+        return;
+    }
+
+    size_t taken = headless_queue_len < len ? headless_queue_len : len;
+
+    memcpy(samples, headless_queue, taken);
+    memset((uint8_t*)samples + taken, 0, len - taken);
+    memmove(headless_queue, headless_queue + taken, headless_queue_len - taken);
+
+    headless_queue_len -= taken;
+}
+
+#define SDL_OpenAudioDevice    headless_open_audio_device
+#define SDL_OpenAudio          headless_open_audio
+#define SDL_PauseAudioDevice   headless_pause_audio_device
+#define SDL_PauseAudio         headless_pause_audio
+#define SDL_LockAudioDevice    headless_lock_audio_device
+#define SDL_UnlockAudioDevice  headless_unlock_audio_device
+#define SDL_LockAudio          headless_lock_audio
+#define SDL_UnlockAudio        headless_unlock_audio
+#define SDL_CloseAudioDevice   headless_close_audio_device
+#define SDL_CloseAudio         headless_close_audio
+#define SDL_QueueAudio         headless_queue_audio
+#define SDL_GetQueuedAudioSize headless_get_queued_audio_size
+
+#endif  // AUDIO_HEADLESS_H
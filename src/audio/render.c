@@ -0,0 +1,181 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______   ______   __   __   _____    ______   ______     //
+//  /\  == \ /\  ___\ /\ "-.\ \ /\  __-. /\  ___\ /\  == \    //
+//  \ \  __< \ \  __\ \ \ \-.  \\ \ \/\ \\ \  __\ \ \  __<    //
+//   \ \_\ \_\\ \_____\\ \_\\"\_\\ \____- \ \_____\\ \_\ \_\  //
+//    \/_/ /_/ \/_____/ \/_/ \/_/ \/____/  \/_____/ \/_/ /_/  //
+//                                                            //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// audio/render.c
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio/audio.h"
+#include "audio/sound.h"
+#include "audio/render.h"
+
+#include "platform/platform.h"
+
+#define RENDER_BLOCK      (512)
+#define RENDER_MAX_PLAYS  (4096)
+#define RENDER_MAX_NAME   (256)
+#define RENDER_WAV_HEADER (44)
+
+static void render_write_u16(FILE* file, uint16_t value) { fwrite(&value, sizeof(uint16_t), 1, file); }
+static void render_write_u32(FILE* file, uint32_t value) { fwrite(&value, sizeof(uint32_t), 1, file); }
+
+static void render_write_header(FILE* file, int rate, uint32_t data_size)
+{
+    fseek(file, 0, SEEK_SET);
+
+    fwrite("RIFF", 1, 4, file);
+    render_write_u32(file, 36 + data_size);
+    fwrite("WAVEfmt ", 1, 8, file);
+    render_write_u32(file, 16);
+    render_write_u16(file, 1);
+    render_write_u16(file, 2);
+    render_write_u32(file, (uint32_t)rate);
+    render_write_u32(file, (uint32_t)rate * 4);
+    render_write_u16(file, 4);
+    render_write_u16(file, 16);
+    fwrite("data", 1, 4, file);
+    render_write_u32(file, data_size);
+}
+
+// commands take effect at the start of their frame, blocks
+// are cut short so none of them lands inside one
+static uint64_t render_mix(FILE* file, uint64_t frame, uint64_t until, double* seconds)
+{
+    int16_t samples[RENDER_BLOCK * 2];
+
+    double frequency = 1.0 / (double)platform_get_ticks_frequency();
+
+    while (frame < until)
+    {
+        int frames = until - frame < RENDER_BLOCK ? (int)(until - frame) : RENDER_BLOCK;
+
+        uint64_t start = platform_get_ticks();
+
+        audio_render(samples, frames);
+
+        *seconds += (platform_get_ticks() - start) * frequency;
+
+        fwrite(samples, sizeof(int16_t), (size_t)frames * 2, file);
+
+        frame += frames;
+    }
+
+    return frame;
+}
+
+bool render_commands(const char* commands, const char* filepath, render_find_func find)
+{
+    assert(audio_is_headless());
+
+    FILE* log = fopen(commands, "r");
+
+    if (log == NULL) return false;
+
+    FILE* file = fopen(filepath, "wb");
+
+    if (file == NULL)
+    {
+        fclose(log);
+        return false;
+    }
+
+    int rate = audio_get_stats().sample_rate;
+
+    render_write_header(file, rate, 0);
+
+    sound_ref_t* plays     = (sound_ref_t*)malloc(sizeof(sound_ref_t) * RENDER_MAX_PLAYS);
+    size_t       plays_len = 0;
+
+    assert(plays);
+
+    uint64_t frame   = 0;
+    double   seconds = 0.0;
+    bool     ok      = true;
+
+    char line[512];
+
+    while (ok && fgets(line, sizeof(line), log))
+    {
+        unsigned long long at;
+        char               command[16];
+        int                read;
+
+        if (line[0] == '#' || sscanf(line, "%llu %15s%n", &at, command, &read) < 2) continue;
+
+        const char* args = line + read;
+
+        if (at < frame)
+        {
+#ifdef DEBUG
+            printf("[RENDER] Command at frame %llu is out of order\n", at);
+#endif
+            ok = false;
+            break;
+        }
+
+        frame = render_mix(file, frame, at, &seconds);
+
+        if (strcmp(command, "end") == 0) break;
+
+        if (strcmp(command, "listener") == 0)
+        {
+            float x = 0.0f, y = 0.0f;
+
+            sscanf(args, "%f %f", &x, &y);
+            sound_set_listener(x, y);
+            continue;
+        }
+
+        if (strcmp(command, "play") == 0)
+        {
+            char  name[RENDER_MAX_NAME];
+            float volume = 1.0f;
+            int   loop   = 0;
+            float x, y;
+
+            int positional = sscanf(args, "%255s %f %d %f %f", name, &volume, &loop, &x, &y) == 5;
+
+            sound_t* sound = find(name);
+
+            if (sound == NULL || plays_len == RENDER_MAX_PLAYS)
+            {
+#ifdef DEBUG
+                printf("[RENDER] Can't play \"%s\"\n", name);
+#endif
+                ok = false;
+                break;
+            }
+
+            plays[plays_len++] = positional ? sound_play_at(sound, volume, loop != 0, x, y) : sound_play(sound, volume, loop != 0);
+            continue;
+        }
+
+        size_t play   = 0;
+        float  value = 0.0f, y = 0.0f;
+
+        if (sscanf(args, "%zu %f %f", &play, &value, &y) < 1 || play >= plays_len) continue;
+
+        if (strcmp(command, "volume") == 0) sound_set_volume(plays[play], value);
+        if (strcmp(command, "position") == 0) sound_set_position(plays[play], value, y);
+        if (strcmp(command, "stop") == 0) sound_stop(plays[play]);
+    }
+
+    render_write_header(file, rate, (uint32_t)(frame * 4));
+
+    fclose(file);
+    fclose(log);
+    free(plays);
+
+    printf("[RENDER] %llu frames mixed in %.2fms, %.1fx realtime\n", (unsigned long long)frame, seconds * 1000.0, seconds > 0.0 ? (double)frame / rate / seconds : 0.0);
+
+    return ok;
+}
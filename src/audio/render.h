@@ -0,0 +1,42 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______   ______   __   __   _____    ______   ______     //
+//  /\  == \ /\  ___\ /\ "-.\ \ /\  __-. /\  ___\ /\  == \    //
+//  \ \  __< \ \  __\ \ \ \-.  \\ \ \/\ \\ \  __\ \ \  __<    //
+//   \ \_\ \_\\ \_____\\ \_\\"\_\\ \____- \ \_____\\ \_\ \_\  //
+//    \/_/ /_/ \/_____/ \/_/ \/_/ \/____/  \/_____/ \/_/ /_/  //
+//                                                            //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// audio/render.h
+
+#ifndef AUDIO_RENDER_H
+#define AUDIO_RENDER_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct sound_t sound_t;
+
+    // one command per line, at a frame counted from the start:
+    //   <frame> play <sound> <volume> <loop> [<x> <y>]
+    //   <frame> volume <play> <volume>
+    //   <frame> position <play> <x> <y>
+    //   <frame> listener <x> <y>
+    //   <frame> stop <play>
+    //   <frame> end
+    // plays are numbered from 0 in the order they appear
+    typedef sound_t* (*render_find_func)(const char* name);
+
+    // drives the headless mixer from the log and writes the
+    // mix as a 16 bit stereo wav, the same log always gives
+    // the same file, the time it took is printed
+    bool render_commands(const char* commands, const char* filepath, render_find_func find);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // AUDIO_RENDER_H
@@ -0,0 +1,241 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______   ______   ______   ______   __    __   ______  __       ______     //
+//  /\  == \ /\  ___\ /\  ___\ /\  __ \ /\ "-./  \ /\  == \/\ \     /\  ___\    //
+//  \ \  __< \ \  __\ \ \___  \\ \  __ \\ \ \-./\ \\ \  _-/\ \ \____\ \  __\    //
+//   \ \_\ \_\\ \_____\\/\_____\\ \_\ \_\\ \_\ \ \_\\ \_\   \ \_____\\ \_____\  //
+//    \/_/ /_/ \/_____/ \/_____/ \/_/\/_/ \/_/  \/_/ \/_/    \/_____/ \/_____/  //
+//                                                                              //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// audio/resample.c
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RESAMPLE_SSE2
+#endif
+
+#include "audio/resample.h"
+
+// 16 taps over 64 phases, a windowed sinc
+// that's clean well past what the clips need
+#define RESAMPLE_TAPS       (16)
+#define RESAMPLE_PHASES     (64)
+#define RESAMPLE_WAV_HEADER (44)
+
+#define RESAMPLE_PI (3.14159265358979323846)
+
+typedef struct resample_format_t
+{
+    int            tag;
+    int            channels;
+    int            rate;
+    int            bits;
+    const uint8_t* data;
+    size_t         frames;
+} resample_format_t;
+
+static uint16_t resample_read_u16(const uint8_t* bytes) { return (uint16_t)(bytes[0] | bytes[1] << 8); }
+static uint32_t resample_read_u32(const uint8_t* bytes) { return (uint32_t)resample_read_u16(bytes) | (uint32_t)resample_read_u16(bytes + 2) << 16; }
+
+static void resample_write_u16(uint8_t* bytes, uint16_t value) { memcpy(bytes, &value, sizeof(uint16_t)); }
+static void resample_write_u32(uint8_t* bytes, uint32_t value) { memcpy(bytes, &value, sizeof(uint32_t)); }
+
+static bool resample_parse(const uint8_t* data, size_t size, resample_format_t* format)
+{
+    if (size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) return false;
+
+    size_t offset = 12;
+    size_t bytes  = 0;
+
+    memset(format, 0, sizeof(resample_format_t));
+
+    while (offset + 8 <= size)
+    {
+        const uint8_t* chunk      = data + offset;
+        size_t         chunk_size = resample_read_u32(chunk + 4);
+
+        if (chunk_size > size - offset - 8) chunk_size = size - offset - 8;
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16)
+        {
+            format->tag      = resample_read_u16(chunk + 8);
+            format->channels = resample_read_u16(chunk + 10);
+            format->rate     = (int)resample_read_u32(chunk + 12);
+            format->bits     = resample_read_u16(chunk + 22);
+
+            // extensible headers keep the real tag in the sub format
+            if (format->tag == 0xFFFE && chunk_size >= 26) format->tag = resample_read_u16(chunk + 32);
+        }
+        else if (memcmp(chunk, "data", 4) == 0)
+        {
+            format->data = chunk + 8;
+            bytes        = chunk_size;
+        }
+
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+
+    bool is_pcm   = format->tag == 1 && (format->bits == 8 || format->bits == 16 || format->bits == 24 || format->bits == 32);
+    bool is_float = format->tag == 3 && format->bits == 32;
+
+    if (!(is_pcm || is_float) || format->channels < 1 || format->rate <= 0 || format->data == NULL) return false;
+
+    format->frames = bytes / ((size_t)format->channels * (format->bits / 8));
+
+    return format->frames > 0;
+}
+
+static float resample_read_sample(const resample_format_t* format, size_t frame, int channel)
+{
+    int            stride = format->bits / 8;
+    const uint8_t* sample = format->data + (frame * format->channels + channel) * stride;
+
+    if (format->tag == 3)
+    {
+        float value;
+        memcpy(&value, sample, sizeof(float));
+        return value;
+    }
+
+    switch (format->bits)
+    {
+        case 8: return ((float)sample[0] - 128.0f) / 128.0f;
+        case 16: return (float)(int16_t)resample_read_u16(sample) / 32768.0f;
+        case 24: return (float)((int32_t)((uint32_t)sample[0] << 8 | (uint32_t)sample[1] << 16 | (uint32_t)sample[2] << 24) >> 8) / 8388608.0f;
+        default: return (float)(int32_t)resample_read_u32(sample) / 2147483648.0f;
+    }
+}
+
+// phases hold the kernel shifted by p / PHASES of a sample, the
+// cutoff drops below nyquist of the lower rate when downsampling
+static void resample_build_kernel(float* kernel, double cutoff)
+{
+    for (int p = 0; p < RESAMPLE_PHASES; ++p)
+    {
+        float* phase = &kernel[p * RESAMPLE_TAPS];
+        double sum   = 0.0;
+
+        for (int t = 0; t < RESAMPLE_TAPS; ++t)
+        {
+            double x      = (double)(t - RESAMPLE_TAPS / 2 + 1) - (double)p / RESAMPLE_PHASES;
+            double sinc   = x == 0.0 ? 1.0 : sin(RESAMPLE_PI * cutoff * x) / (RESAMPLE_PI * cutoff * x);
+            double window = 0.42 + 0.5 * cos(RESAMPLE_PI * x / (RESAMPLE_TAPS / 2)) + 0.08 * cos(2.0 * RESAMPLE_PI * x / (RESAMPLE_TAPS / 2));
+
+            phase[t] = (float)(sinc * window);
+            sum += phase[t];
+        }
+
+        for (int t = 0; t < RESAMPLE_TAPS; ++t) phase[t] = (float)(phase[t] / sum);
+    }
+}
+
+static float resample_dot(const float* samples, const float* phase)
+{
+#ifdef RESAMPLE_SSE2
+    __m128 sum = _mm_setzero_ps();
+
+    for (int t = 0; t < RESAMPLE_TAPS; t += 4) sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(samples + t), _mm_loadu_ps(phase + t)));
+
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+
+    return _mm_cvtss_f32(sum);
+#else
+    float sum = 0.0f;
+
+    for (int t = 0; t < RESAMPLE_TAPS; ++t) sum += samples[t] * phase[t];
+
+    return sum;
+#endif
+}
+
+static int16_t resample_to_i16(float value)
+{
+    float scaled = value * 32767.0f;
+
+    if (scaled > 32767.0f) return 32767;
+    if (scaled < -32768.0f) return -32768;
+
+    return (int16_t)lrintf(scaled);
+}
+
+void* resample_wav(const void* data, size_t size, int rate, size_t* out_size)
+{
+    resample_format_t format;
+
+    if (!resample_parse((const uint8_t*)data, size, &format)) return NULL;
+
+    if (format.tag == 1 && format.bits == 16 && format.channels == 2 && format.rate == rate) return NULL;
+
+    size_t frames = (size_t)((double)format.frames * rate / format.rate);
+
+    *out_size = RESAMPLE_WAV_HEADER + frames * 4;
+
+    uint8_t* wav = (uint8_t*)malloc(*out_size);
+
+    // channels are padded with silence on both
+    // sides so the kernel never reads past them
+    size_t padded  = format.frames + RESAMPLE_TAPS * 2;
+    float* channel = (float*)calloc(padded, sizeof(float));
+    float* kernel  = (float*)malloc(RESAMPLE_TAPS * RESAMPLE_PHASES * sizeof(float));
+
+    assert(wav && channel && kernel);
+
+    double step = (double)format.rate / rate;
+
+    resample_build_kernel(kernel, step > 1.0 ? 0.95 / step : 0.95);
+
+    int16_t* out = (int16_t*)(wav + RESAMPLE_WAV_HEADER);
+
+    // mono is written to both sides, anything past
+    // stereo only keeps its first two channels
+    for (int c = 0; c < 2; ++c)
+    {
+        int source = c < format.channels ? c : 0;
+
+        for (size_t i = 0; i < format.frames; ++i) channel[RESAMPLE_TAPS + i] = resample_read_sample(&format, i, source);
+
+        for (size_t i = 0; i < frames; ++i)
+        {
+            double position = (double)i * step;
+            size_t index    = (size_t)position;
+            int    phase    = (int)((position - (double)index) * RESAMPLE_PHASES + 0.5);
+
+            if (phase == RESAMPLE_PHASES)
+            {
+                phase = 0;
+                ++index;
+            }
+
+            const float* samples = &channel[RESAMPLE_TAPS + index - RESAMPLE_TAPS / 2 + 1];
+
+            out[i * 2 + c] = resample_to_i16(resample_dot(samples, &kernel[phase * RESAMPLE_TAPS]));
+        }
+    }
+
+    free(channel);
+    free(kernel);
+
+    uint32_t data_size = (uint32_t)(frames * 4);
+
+    memcpy(wav, "RIFF", 4);
+    resample_write_u32(wav + 4, 36 + data_size);
+    memcpy(wav + 8, "WAVEfmt ", 8);
+    resample_write_u32(wav + 16, 16);
+    resample_write_u16(wav + 20, 1);
+    resample_write_u16(wav + 22, 2);
+    resample_write_u32(wav + 24, (uint32_t)rate);
+    resample_write_u32(wav + 28, (uint32_t)rate * 4);
+    resample_write_u16(wav + 32, 4);
+    resample_write_u16(wav + 34, 16);
+    memcpy(wav + 36, "data", 4);
+    resample_write_u32(wav + 40, data_size);
+
+    return wav;
+}
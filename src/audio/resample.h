@@ -0,0 +1,29 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______   ______   ______   ______   __    __   ______  __       ______     //
+//  /\  == \ /\  ___\ /\  ___\ /\  __ \ /\ "-./  \ /\  == \/\ \     /\  ___\    //
+//  \ \  __< \ \  __\ \ \___  \\ \  __ \\ \ \-./\ \\ \  _-/\ \ \____\ \  __\    //
+//   \ \_\ \_\\ \_____\\/\_____\\ \_\ \_\\ \_\ \ \_\\ \_\   \ \_____\\ \_____\  //
+//    \/_/ /_/ \/_____/ \/_____/ \/_/\/_/ \/_/  \/_/ \/_/    \/_____/ \/_____/  //
+//                                                                              //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// audio/resample.h
+
+#ifndef AUDIO_RESAMPLE_H
+#define AUDIO_RESAMPLE_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // returns a malloc'd 16 bit stereo wav at rate, or null when
+    // the clip already is one or isn't a wav that can be read
+    void* resample_wav(const void* data, size_t size, int rate, size_t* out_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // AUDIO_RESAMPLE_H
@@ -9,47 +9,583 @@
 // audio/sounds.c
 
 #include <assert.h>
+#include <math.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "SDL.h"
 #include "cute_sound.h"
 
+#include "audio/audio.h"
 #include "audio/sound.h"
+#include "audio/stream.h"
+#include "audio/resample.h"
+
+#include "platform/filesystem.h"
+
+// every fruit pickup starts two voices, the cap keeps
+// the mixer bounded however fast a chain goes
+#define SOUND_MAX_VOICES    (24)
+#define SOUND_MAX_TRACKED   (64)
+#define SOUND_MAX_INSTANCES (4)
+#define SOUND_MAX_COMMANDS  (256)
+
+// all of the screen plays at full volume, fading out
+// over a screen and a half, quieter than -40db isn't mixed
+#define SOUND_DISTANCE_MIN (640.0f)
+#define SOUND_DISTANCE_MAX (2560.0f)
+#define SOUND_AUDIBLE      (0.01f)
 
 struct sound_t
 {
     cs_audio_source_t* source;
+    stream_t*          stream;
+    int                max_instances;
+    SOUND_PRIORITY     priority;
 };
 
+// a virtual voice is tracked with its position but
+// has no voice in the mixer until it's heard again
+typedef struct sound_voice_t
+{
+    sound_t*    sound;
+    sound_ref_t ref;
+    uint64_t    id;  // cute_sound's, only known on the audio thread
+    float       volume;
+    float       gain;  // the volume after distance
+    bool        loop;
+    bool        positional;
+    bool        real;
+    float       x, y;
+    double      index;  // in samples, kept while virtual
+    uint64_t    started;
+} sound_voice_t;
+
+typedef enum SOUND_COMMAND
+{
+    SOUND_COMMAND_PLAY,
+    SOUND_COMMAND_STOP,
+    SOUND_COMMAND_VOLUME,
+    SOUND_COMMAND_POSITION,
+    SOUND_COMMAND_LISTENER,
+} SOUND_COMMAND;
+
+typedef struct sound_command_t
+{
+    SOUND_COMMAND type;
+    sound_t*      sound;
+    sound_ref_t   ref;
+    float         volume;
+    bool          loop;
+    bool          positional;
+    float         x, y;
+} sound_command_t;
+
+// the game thread only pushes, the audio thread only pops,
+// head and tail are each written by one side alone
+static sound_command_t sound_commands[SOUND_MAX_COMMANDS];
+static SDL_atomic_t    sound_commands_head;
+static SDL_atomic_t    sound_commands_tail;
+static sound_ref_t     sound_refs;
+
+// held while commands run, so deleting a sound
+// can drain the queue in place of the audio thread
+static SDL_mutex* sound_mutex;
+static int        sound_rate = 44100;
+
+static sound_voice_t sound_voices[SOUND_MAX_TRACKED];
+static size_t        sound_voices_len;
+static uint64_t      sound_voices_started;
+
+static float sound_listener_x;
+static float sound_listener_y;
+
+static void sound_init_source(sound_t* sound, cs_audio_source_t* source)
+{
+    sound->source        = source;
+    sound->stream        = NULL;
+    sound->max_instances = SOUND_MAX_INSTANCES;
+    sound->priority      = SOUND_PRIORITY_NORMAL;
+}
+
 sound_t* sound_new(const char* filepath)
+{
+    size_t size;
+    char*  data = filesystem_read_file(filepath, &size);
+
+    assert(data);
+
+    sound_t* sound = sound_new_from_memory(data, size);
+
+    free(data);
+
+    return sound;
+}
+
+void* sound_convert(const void* data, size_t size, size_t* converted_size) { return resample_wav(data, size, sound_rate, converted_size); }
+
+int sound_get_sample_rate(void) { return sound_rate; }
+
+// clips are brought to the device's rate and to stereo
+// here, so voices mix without converting anything
+sound_t* sound_new_from_memory(const void* data, size_t size)
 {
     sound_t* sound = (sound_t*)malloc(sizeof(sound_t));
 
     assert(sound);
 
+    size_t converted_size = 0;
+    void*  converted      = sound_convert(data, size, &converted_size);
+
     cs_error_t         error;
-    cs_audio_source_t* source = cs_load_wav(filepath, &error);
+    cs_audio_source_t* source = converted ? cs_read_mem_wav(converted, converted_size, &error) : cs_read_mem_wav(data, size, &error);
 
     assert(error == CUTE_SOUND_ERROR_NONE);
 
-    sound->source = source;
+    free(converted);
+
+    sound_init_source(sound, source);
+
+    return sound;
+}
+
+// a stream has one ring to play from,
+// so it only ever plays once at a time
+static sound_t* sound_new_stream_from(stream_t* stream)
+{
+    if (stream == NULL) return NULL;
+
+    sound_t* sound = (sound_t*)malloc(sizeof(sound_t));
+
+    assert(sound);
+
+    sound_init_source(sound, stream_get_source(stream));
+
+    sound->stream        = stream;
+    sound->max_instances = 1;
 
     return sound;
 }
 
-void sound_delete(sound_t* sound) { cs_free_audio_source(sound->source); }
+sound_t* sound_new_stream(const char* filepath) { return sound_new_stream_from(stream_open(filepath, sound_rate)); }
+
+sound_t* sound_new_stream_from_memory(const void* data, size_t size) { return sound_new_stream_from(stream_open_memory(data, size, sound_rate)); }
+
+static void sound_drain(void);
+
+void sound_init(int sample_rate)
+{
+    sound_mutex = SDL_CreateMutex();
+    sound_rate  = sample_rate;
+}
+
+void sound_shutdown(void)
+{
+    SDL_DestroyMutex(sound_mutex);
+    sound_mutex = NULL;
+}
+
+void sound_lock(void) { SDL_LockMutex(sound_mutex); }
+void sound_unlock(void) { SDL_UnlockMutex(sound_mutex); }
+
+static void sound_remove_voice(size_t index)
+{
+    sound_voices[index] = sound_voices[--sound_voices_len];
+}
+
+static void sound_stop_voice(size_t index)
+{
+    if (sound_voices[index].real) audio_voice_stop(sound_voices[index].id);
+
+    sound_remove_voice(index);
+}
+
+void sound_delete(sound_t* sound)
+{
+    sound_lock();
+    sound_drain();
+
+    for (size_t i = sound_voices_len; i-- > 0;)
+    {
+        if (sound_voices[i].sound == sound) sound_stop_voice(i);
+    }
+
+    if (sound->stream) stream_close(sound->stream);
+    else cs_free_audio_source(sound->source);
+
+    sound_unlock();
+
+    free(sound);
+}
+
+void sound_set_limits(sound_t* sound, int max_instances, SOUND_PRIORITY priority)
+{
+    assert(max_instances > 0);
+    assert(sound->stream == NULL || max_instances == 1);
+
+    sound->max_instances = max_instances;
+    sound->priority      = priority;
+}
+
+// finished voices are only noticed here,
+// there's nothing to do for them per frame
+static void sound_reap_voices(void)
+{
+    for (size_t i = sound_voices_len; i-- > 0;)
+    {
+        if (sound_voices[i].real && !audio_voice_is_active(sound_voices[i].id)) sound_remove_voice(i);
+    }
+}
+
+// linear between the two distances, sounds
+// without a position follow the listener
+static float sound_attenuate(const sound_voice_t* voice)
+{
+    if (!voice->positional) return voice->volume;
+
+    float distance = hypotf(voice->x - sound_listener_x, voice->y - sound_listener_y);
+
+    if (distance <= SOUND_DISTANCE_MIN) return voice->volume;
+    if (distance >= SOUND_DISTANCE_MAX) return 0.0f;
+
+    return voice->volume * (1.0f - (distance - SOUND_DISTANCE_MIN) / (SOUND_DISTANCE_MAX - SOUND_DISTANCE_MIN));
+}
+
+// lower priority goes first, then the quieter,
+// then the older of two voices
+static bool sound_voice_before(const sound_voice_t* a, const sound_voice_t* b)
+{
+    if (a->sound->priority != b->sound->priority) return a->sound->priority < b->sound->priority;
+    if (a->gain != b->gain) return a->gain < b->gain;
+
+    return a->started < b->started;
+}
+
+static size_t sound_count_real(void)
+{
+    size_t real = 0;
+
+    for (size_t i = 0; i < sound_voices_len; ++i) real += sound_voices[i].real;
+
+    return real;
+}
+
+// a stream's ring is filled for the voice it's attached
+// to, so streams stay real and are never given up
+static size_t sound_find_victim(const sound_voice_t* voice)
+{
+    size_t victim = SOUND_MAX_TRACKED;
+
+    for (size_t i = 0; i < sound_voices_len; ++i)
+    {
+        if (!sound_voices[i].real || sound_voices[i].sound->stream) continue;
+
+        if (victim == SOUND_MAX_TRACKED || sound_voice_before(&sound_voices[i], &sound_voices[victim])) victim = i;
+    }
+
+    if (victim == SOUND_MAX_TRACKED || !sound_voice_before(&sound_voices[victim], voice)) return SOUND_MAX_TRACKED;
+
+    return victim;
+}
+
+static void sound_virtualize(size_t index)
+{
+    sound_voice_t* voice = &sound_voices[index];
+
+    voice->index = audio_voice_get_index(voice->id);
+    voice->real  = false;
+
+    audio_voice_stop(voice->id);
+}
+
+// picks up where the virtual voice would have been,
+// a stream only ever gets here when it starts
+static void sound_realize(size_t index)
+{
+    sound_voice_t* voice = &sound_voices[index];
+    sound_t*       sound = voice->sound;
+
+    if (sound->stream) stream_rewind(sound->stream, voice->loop);
+
+    voice->id   = audio_voice_play(sound->source, voice->gain, voice->loop || sound->stream);
+    voice->real = true;
+
+    if (sound->stream) stream_attach(sound->stream, voice->id);
+    else if (voice->index > 0.0) audio_voice_set_index(voice->id, (int)voice->index);
+}
+
+// over the cap the weakest real voice
+// goes virtual to make way for this one
+static bool sound_make_real(size_t index)
+{
+    if (sound_count_real() >= SOUND_MAX_VOICES)
+    {
+        size_t victim = sound_find_victim(&sound_voices[index]);
+
+        if (victim == SOUND_MAX_TRACKED) return false;
+
+        sound_virtualize(victim);
+    }
+
+    sound_realize(index);
+    return true;
+}
+
+static bool sound_make_room(const sound_voice_t* voice)
+{
+    size_t instances = 0;
+    size_t oldest    = SOUND_MAX_TRACKED;
+
+    for (size_t i = 0; i < sound_voices_len; ++i)
+    {
+        if (sound_voices[i].sound != voice->sound) continue;
+
+        if (oldest == SOUND_MAX_TRACKED || sound_voices[i].started < sound_voices[oldest].started) oldest = i;
+
+        ++instances;
+    }
+
+    // a sound over its own cap restarts its oldest
+    // instance, it never takes a voice from another
+    if (instances >= (size_t)voice->sound->max_instances)
+    {
+        sound_stop_voice(oldest);
+        return true;
+    }
+
+    if (sound_voices_len < SOUND_MAX_TRACKED) return true;
+
+    size_t victim = 0;
+
+    for (size_t i = 1; i < sound_voices_len; ++i)
+    {
+        if (sound_voice_before(&sound_voices[i], &sound_voices[victim])) victim = i;
+    }
+
+    if (!sound_voice_before(&sound_voices[victim], voice)) return false;
+
+    sound_stop_voice(victim);
+    return true;
+}
+
+static void sound_execute_play(const sound_command_t* command)
+{
+    sound_reap_voices();
+
+    sound_voice_t voice = {
+        .sound      = command->sound,
+        .ref        = command->ref,
+        .volume     = command->volume,
+        .loop       = command->loop,
+        .positional = command->positional,
+        .x          = command->x,
+        .y          = command->y,
+        .started    = sound_voices_started++,
+    };
+
+    voice.gain = sound_attenuate(&voice);
+
+    if (!sound_make_room(&voice)) return;
+
+    size_t index = sound_voices_len++;
+
+    sound_voices[index] = voice;
+
+    // out of earshot it starts virtual, a stream that
+    // can't be mixed right away isn't played at all
+    if (voice.gain < SOUND_AUDIBLE && !voice.sound->stream) return;
+
+    if (!sound_make_real(index) && voice.sound->stream) sound_remove_voice(index);
+}
+
+// virtual voices move on as if they were mixed,
+// one shots that would have finished are dropped
+static void sound_advance_virtual(double elapsed)
+{
+    for (size_t i = sound_voices_len; i-- > 0;)
+    {
+        sound_voice_t* voice = &sound_voices[i];
+
+        if (voice->real) continue;
+
+        double length = (double)audio_get_sample_count(voice->sound->source);
+
+        voice->index += elapsed * sound_rate;
+
+        if (voice->index < length) continue;
+
+        if (voice->loop) voice->index = fmod(voice->index, length);
+        else sound_remove_voice(i);
+    }
+}
+
+static void sound_update_voices(double elapsed)
+{
+    sound_reap_voices();
+    sound_advance_virtual(elapsed);
+
+    for (size_t i = 0; i < sound_voices_len; ++i)
+    {
+        sound_voice_t* voice = &sound_voices[i];
+
+        float gain = sound_attenuate(voice);
+
+        if (voice->real && gain < SOUND_AUDIBLE && !voice->sound->stream) sound_virtualize(i);
+        else if (voice->real && gain != voice->gain) audio_voice_set_volume(voice->id, gain);
+
+        voice->gain = gain;
+    }
+
+    for (size_t i = 0; i < sound_voices_len; ++i)
+    {
+        if (!sound_voices[i].real && sound_voices[i].gain >= SOUND_AUDIBLE) sound_make_real(i);
+    }
+}
 
+static void sound_execute(const sound_command_t* command)
+{
+    if (command->type == SOUND_COMMAND_PLAY)
+    {
+        sound_execute_play(command);
+        return;
+    }
+
+    if (command->type == SOUND_COMMAND_LISTENER)
+    {
+        sound_listener_x = command->x;
+        sound_listener_y = command->y;
+        return;
+    }
+
+    for (size_t i = 0; i < sound_voices_len; ++i)
+    {
+        if (sound_voices[i].ref != command->ref) continue;
+
+        if (command->type == SOUND_COMMAND_STOP)
+        {
+            sound_stop_voice(i);
+            return;
+        }
+
+        // the new gain is applied when
+        // the voices are updated next
+        if (command->type == SOUND_COMMAND_VOLUME) sound_voices[i].volume = command->volume;
+
+        if (command->type == SOUND_COMMAND_POSITION)
+        {
+            sound_voices[i].x = command->x;
+            sound_voices[i].y = command->y;
+        }
+
+        return;
+    }
+}
+
+static void sound_push(sound_command_t command)
+{
+    uint32_t head = (uint32_t)SDL_AtomicGet(&sound_commands_head);
+    uint32_t tail = (uint32_t)SDL_AtomicGet(&sound_commands_tail);
+
+    if (head - tail == SOUND_MAX_COMMANDS)
+    {
+#ifdef DEBUG
+        printf("[SOUND] Command queue full, dropped a command\n");
+#endif
+        return;
+    }
+
+    sound_commands[head % SOUND_MAX_COMMANDS] = command;
+
+    SDL_AtomicSet(&sound_commands_head, (int)(head + 1));
+}
+
+static void sound_drain(void)
+{
+    uint32_t head = (uint32_t)SDL_AtomicGet(&sound_commands_head);
+    uint32_t tail = (uint32_t)SDL_AtomicGet(&sound_commands_tail);
+
+    for (; tail != head; ++tail) sound_execute(&sound_commands[tail % SOUND_MAX_COMMANDS]);
+
+    SDL_AtomicSet(&sound_commands_tail, (int)tail);
+}
+
+void sound_process(double elapsed)
+{
+    sound_lock();
+    sound_drain();
+    sound_update_voices(elapsed);
+    stream_update();
+    sound_unlock();
+}
+
+void sound_restart(void)
+{
+    sound_lock();
+
+    // loops come back from their start under the same
+    // ref, one shots are simply cut short, virtual
+    // voices never had a voice to lose
+    for (size_t i = sound_voices_len; i-- > 0;)
+    {
+        sound_voice_t* voice = &sound_voices[i];
+
+        if (!voice->real) continue;
+
+        if (voice->loop)
+        {
+            voice->index = 0.0;
+
+            sound_realize(i);
+        }
+        else sound_remove_voice(i);
+    }
+
+    sound_unlock();
+}
+
+// refs are handed out here so play can return at once,
+// a play dropped for lack of voices leaves a dead ref
 sound_ref_t sound_play(sound_t* sound, float volume, bool loop)
 {
-    cs_sound_params_t csparams = cs_sound_params_default();
+    sound_ref_t ref = ++sound_refs;
+
+    sound_push((sound_command_t){SOUND_COMMAND_PLAY, sound, ref, volume, loop, false, 0.0f, 0.0f});
+
+    return ref;
+}
+
+sound_ref_t sound_play_at(sound_t* sound, float volume, bool loop, float x, float y)
+{
+    sound_ref_t ref = ++sound_refs;
 
-    csparams.volume = volume;
-    csparams.looped = loop;
+    sound_push((sound_command_t){SOUND_COMMAND_PLAY, sound, ref, volume, loop, true, x, y});
+
+    return ref;
+}
+
+void sound_stop(sound_ref_t ref)
+{
+    if (ref == 0) return;
+
+    sound_push((sound_command_t){SOUND_COMMAND_STOP, NULL, ref, 0.0f, false, false, 0.0f, 0.0f});
+}
+
+void sound_set_volume(sound_ref_t ref, float volume)
+{
+    if (ref == 0) return;
+
+    sound_push((sound_command_t){SOUND_COMMAND_VOLUME, NULL, ref, volume, false, false, 0.0f, 0.0f});
+}
+
+void sound_set_position(sound_ref_t ref, float x, float y)
+{
+    if (ref == 0) return;
 
-    return cs_play_sound(sound->source, csparams).id;
+    sound_push((sound_command_t){SOUND_COMMAND_POSITION, NULL, ref, 0.0f, false, true, x, y});
 }
 
-void sound_set_volume(sound_ref_t id, float volume)
+void sound_set_listener(float x, float y)
 {
-    cs_playing_sound_t cssound = (cs_playing_sound_t){.id = id};
-    cs_sound_set_volume(cssound, volume);
+    sound_push((sound_command_t){SOUND_COMMAND_LISTENER, NULL, 0, 0.0f, false, false, x, y});
 }
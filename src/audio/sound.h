@@ -12,8 +12,13 @@
 #define AUDIO_SOUND_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+// wavs from this size on are streamed, about
+// six seconds of 16 bit stereo at 44.1khz
+#define SOUND_STREAM_SIZE (1024 * 1024)
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -22,12 +27,66 @@ extern "C"
     typedef struct sound_t sound_t;
     typedef uint64_t       sound_ref_t;
 
+    typedef enum SOUND_PRIORITY
+    {
+        SOUND_PRIORITY_LOW,
+        SOUND_PRIORITY_NORMAL,
+        SOUND_PRIORITY_HIGH,
+    } SOUND_PRIORITY;
+
     sound_t* sound_new(const char* filepath);
+    sound_t* sound_new_from_memory(const void* data, size_t size);
     void     sound_delete(sound_t* sound);
 
+    // the wav as it's converted on load, stereo at the device's
+    // rate, NULL when it already is, loading the result again
+    // converts nothing so it can be cached between runs
+    void* sound_convert(const void* data, size_t size, size_t* converted_size);
+    int   sound_get_sample_rate(void);
+
+    // long tracks are decoded as they play instead of whole,
+    // memory passed in has to outlive the sound, NULL for a
+    // track that isn't at the device's rate and needs a load
+    sound_t* sound_new_stream(const char* filepath);
+    sound_t* sound_new_stream_from_memory(const void* data, size_t size);
+
+    // a sound plays at most max_instances at once, over the voice
+    // cap the lowest priority, quietest, oldest voice is stolen
+    void sound_set_limits(sound_t* sound, int max_instances, SOUND_PRIORITY priority);
+
+    // play, stop and volume only queue a command for the audio
+    // thread, the ref is valid at once even if the play is dropped
     sound_ref_t sound_play(sound_t* sound, float volume, bool loop);
 
-    void sound_set_volume(sound_ref_t id, float volume);
+    // fades with the distance to the listener, voices too far
+    // or too quiet to hear go virtual, they keep their place
+    // without being mixed and resume from it once audible
+    sound_ref_t sound_play_at(sound_t* sound, float volume, bool loop, float x, float y);
+
+    void sound_stop(sound_ref_t ref);
+    void sound_set_volume(sound_ref_t ref, float volume);
+    void sound_set_position(sound_ref_t ref, float x, float y);
+
+    // in world units, the game keeps it on the camera
+    void sound_set_listener(float x, float y);
+
+    // the queue lives between init and shutdown, process runs
+    // it on the thread that mixes, clips loaded after init are
+    // converted to the sample rate given here, elapsed is the
+    // time in seconds since it last ran
+    void sound_init(int sample_rate);
+    void sound_shutdown(void);
+    void sound_process(double elapsed);
+
+    // replays the looping voices after
+    // the mixer has been reopened
+    void sound_restart(void);
+
+    // the mixer holds this for a whole mix and any reopen, so a
+    // sound is never freed while cute_sound reads its source,
+    // sdl's mutexes nest so process and restart lock inside it
+    void sound_lock(void);
+    void sound_unlock(void);
 
 #ifdef __cplusplus
 }
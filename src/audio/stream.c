@@ -0,0 +1,410 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______   ______  ______   ______   ______   __    __     //
+//  /\  ___\ /\__  _\/\  == \ /\  ___\ /\  __ \ /\ "-./  \    //
+//  \ \___  \\/_/\ \/\ \  __< \ \  __\ \ \  __ \\ \ \-./\ \   //
+//   \/\_____\  \ \_\ \ \_\ \_\\ \_____\\ \_\ \_\\ \_\ \ \_\  //
+//    \/_____/   \/_/  \/_/ /_/ \/_____/ \/_/\/_/ \/_/  \/_/  //
+//                                                            //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// audio/stream.c
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+#include "cute_sound.h"
+
+#include "audio/audio.h"
+#include "audio/sound.h"
+#include "audio/stream.h"
+
+// 4 chunks of 8192 frames keep ~0.7s decoded
+// ahead, about 256kb for a stereo track
+#define STREAM_CHUNK_FRAMES (8192)
+#define STREAM_CHUNKS       (4)
+#define STREAM_RING_FRAMES  (STREAM_CHUNK_FRAMES * STREAM_CHUNKS)
+#define STREAM_DELAY        (10)
+#define STREAM_MAX          (4)
+#define STREAM_WAV_HEADER   (44)
+
+struct stream_t
+{
+    cs_audio_source_t* source;
+
+    FILE*          file;
+    const uint8_t* data;
+    size_t         data_offset;
+    size_t         data_size;
+    size_t         read;
+
+    int  channels;
+    int  rate;
+    bool loop;
+
+    uint8_t*    wav;  // header then one chunk of pcm
+    SDL_mutex*  mutex;
+    SDL_Thread* thread;
+
+    SDL_atomic_t running;
+    SDL_atomic_t cursor;  // chunks the voice has moved past
+    SDL_atomic_t end;     // frame the data ran out at, -1 when looped
+    int          filled;
+
+    uint64_t voice;
+    int      lap;
+    int      last_index;
+};
+
+// streams are opened by the decode workers and walked by the
+// audio thread, the sound lock guards the table between them
+static stream_t* streams[STREAM_MAX];
+
+static void stream_read(stream_t* stream, size_t offset, void* dst, size_t size)
+{
+    if (stream->data)
+    {
+        memcpy(dst, stream->data + offset, size);
+        return;
+    }
+
+    fseek(stream->file, (long)offset, SEEK_SET);
+
+    size_t read = fread(dst, 1, size, stream->file);
+
+    if (read < size) memset((uint8_t*)dst + read, 0, size - read);
+}
+
+static uint32_t stream_read_u32(const uint8_t* bytes)
+{
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(uint32_t));
+    return value;
+}
+
+// only the fmt and data chunks matter, anything
+// in between is skipped over by its size
+static bool stream_parse(stream_t* stream, size_t size)
+{
+    uint8_t header[16];
+
+    if (size < 12) return false;
+
+    stream_read(stream, 0, header, 12);
+
+    if (memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) return false;
+
+    size_t offset = 12;
+    int    bits   = 0;
+
+    while (offset + 8 <= size)
+    {
+        stream_read(stream, offset, header, 8);
+
+        size_t chunk_size = stream_read_u32(header + 4);
+
+        if (memcmp(header, "fmt ", 4) == 0 && chunk_size >= 16)
+        {
+            stream_read(stream, offset + 8, header, 16);
+
+            stream->channels = header[2] | header[3] << 8;
+            stream->rate     = (int)stream_read_u32(header + 4);
+            bits             = header[14] | header[15] << 8;
+
+            if ((header[0] | header[1] << 8) != 1) return false;
+        }
+        else if (memcmp(header, "data", 4) == 0)
+        {
+            stream->data_offset = offset + 8;
+            stream->data_size   = chunk_size < size - stream->data_offset ? chunk_size : size - stream->data_offset;
+            break;
+        }
+
+        offset += 8 + chunk_size + (chunk_size & 1);
+    }
+
+    size_t frame_size = (size_t)stream->channels * 2;
+
+    stream->data_size -= stream->data_size % (frame_size ? frame_size : 1);
+
+    return bits == 16 && (stream->channels == 1 || stream->channels == 2) && stream->data_size > 0;
+}
+
+static void stream_write_u16(uint8_t* bytes, uint16_t value) { memcpy(bytes, &value, sizeof(uint16_t)); }
+static void stream_write_u32(uint8_t* bytes, uint32_t value) { memcpy(bytes, &value, sizeof(uint32_t)); }
+
+static void stream_write_header(uint8_t* wav, int channels, int rate, size_t frames)
+{
+    uint32_t data_size = (uint32_t)(frames * channels * 2);
+
+    memcpy(wav, "RIFF", 4);
+    stream_write_u32(wav + 4, 36 + data_size);
+    memcpy(wav + 8, "WAVEfmt ", 8);
+    stream_write_u32(wav + 16, 16);
+    stream_write_u16(wav + 20, 1);
+    stream_write_u16(wav + 22, (uint16_t)channels);
+    stream_write_u32(wav + 24, (uint32_t)rate);
+    stream_write_u32(wav + 28, (uint32_t)(rate * channels * 2));
+    stream_write_u16(wav + 32, (uint16_t)(channels * 2));
+    stream_write_u16(wav + 34, 16);
+    memcpy(wav + 36, "data", 4);
+    stream_write_u32(wav + 40, data_size);
+}
+
+// cute_sound does the sample conversion, the chunk is read
+// as a small wav and its channels copied into the ring
+static void stream_decode_chunk(stream_t* stream, int chunk)
+{
+    size_t frame_size = (size_t)stream->channels * 2;
+    size_t chunk_size = STREAM_CHUNK_FRAMES * frame_size;
+
+    uint8_t* pcm     = stream->wav + STREAM_WAV_HEADER;
+    size_t   written = 0;
+
+    while (written < chunk_size)
+    {
+        if (stream->read == stream->data_size)
+        {
+            if (!stream->loop)
+            {
+                if (SDL_AtomicGet(&stream->end) < 0)
+                {
+                    SDL_AtomicSet(&stream->end, (int)(chunk * STREAM_CHUNK_FRAMES + written / frame_size));
+                }
+
+                memset(pcm + written, 0, chunk_size - written);
+                break;
+            }
+
+            stream->read = 0;
+        }
+
+        size_t size = chunk_size - written;
+
+        if (size > stream->data_size - stream->read) size = stream->data_size - stream->read;
+
+        stream_read(stream, stream->data_offset + stream->read, pcm + written, size);
+
+        stream->read += size;
+        written += size;
+    }
+
+    cs_error_t         error;
+    cs_audio_source_t* decoded = cs_read_mem_wav(stream->wav, STREAM_WAV_HEADER + chunk_size, &error);
+
+    assert(error == CUTE_SOUND_ERROR_NONE);
+
+    size_t offset = (size_t)(chunk % STREAM_CHUNKS) * STREAM_CHUNK_FRAMES;
+
+    for (int i = 0; i < stream->channels; ++i)
+    {
+        memcpy(audio_get_samples(stream->source, i) + offset, audio_get_samples(decoded, i), STREAM_CHUNK_FRAMES * sizeof(float));
+    }
+
+    cs_free_audio_source(decoded);
+}
+
+// a chunk is only rewritten once the voice has
+// moved past its previous lap around the ring
+static void stream_fill(stream_t* stream)
+{
+    SDL_LockMutex(stream->mutex);
+
+    while (stream->filled < SDL_AtomicGet(&stream->cursor) + STREAM_CHUNKS)
+    {
+        stream_decode_chunk(stream, stream->filled);
+        ++stream->filled;
+    }
+
+    SDL_UnlockMutex(stream->mutex);
+}
+
+#ifndef __EMSCRIPTEN__
+static int stream_run(void* data)
+{
+    stream_t* stream = (stream_t*)data;
+
+    while (SDL_AtomicGet(&stream->running))
+    {
+        stream_fill(stream);
+        SDL_Delay(STREAM_DELAY);
+    }
+
+    return 0;
+}
+#endif
+
+static stream_t* stream_new(FILE* file, const void* data, size_t size, int rate)
+{
+    stream_t* stream = (stream_t*)calloc(1, sizeof(stream_t));
+
+    assert(stream);
+
+    stream->file = file;
+    stream->data = (const uint8_t*)data;
+
+    if (!stream_parse(stream, size) || stream->rate != rate)
+    {
+        free(stream);
+        return NULL;
+    }
+
+    // the ring starts out as a silent wav of its full length
+    size_t   ring_size = STREAM_WAV_HEADER + STREAM_RING_FRAMES * (size_t)stream->channels * 2;
+    uint8_t* ring      = (uint8_t*)calloc(1, ring_size);
+
+    assert(ring);
+
+    stream_write_header(ring, stream->channels, stream->rate, STREAM_RING_FRAMES);
+
+    cs_error_t error;
+
+    stream->source = cs_read_mem_wav(ring, ring_size, &error);
+
+    assert(error == CUTE_SOUND_ERROR_NONE);
+
+    free(ring);
+
+    stream->wav = (uint8_t*)malloc(STREAM_WAV_HEADER + STREAM_CHUNK_FRAMES * (size_t)stream->channels * 2);
+
+    assert(stream->wav);
+
+    stream_write_header(stream->wav, stream->channels, stream->rate, STREAM_CHUNK_FRAMES);
+
+    stream->mutex = SDL_CreateMutex();
+    stream->loop  = true;
+
+    SDL_AtomicSet(&stream->end, -1);
+
+    stream_fill(stream);
+
+#ifndef __EMSCRIPTEN__
+    if (!audio_is_headless())
+    {
+        SDL_AtomicSet(&stream->running, 1);
+
+        stream->thread = SDL_CreateThread(stream_run, "stream", stream);
+    }
+#endif
+
+    sound_lock();
+
+    int slot = 0;
+
+    while (slot < STREAM_MAX && streams[slot] != NULL) ++slot;
+
+    assert(slot < STREAM_MAX && "too many streams");
+
+    if (slot < STREAM_MAX) streams[slot] = stream;
+
+    sound_unlock();
+
+    return stream;
+}
+
+stream_t* stream_open(const char* filepath, int rate)
+{
+    FILE* file = fopen(filepath, "rb");
+
+    if (file == NULL) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+
+    stream_t* stream = size > 0 ? stream_new(file, NULL, (size_t)size, rate) : NULL;
+
+    if (stream == NULL) fclose(file);
+
+    return stream;
+}
+
+stream_t* stream_open_memory(const void* data, size_t size, int rate) { return stream_new(NULL, data, size, rate); }
+
+void stream_close(stream_t* stream)
+{
+    sound_lock();
+
+    for (int i = 0; i < STREAM_MAX; ++i)
+    {
+        if (streams[i] == stream) streams[i] = NULL;
+    }
+
+    sound_unlock();
+
+    SDL_AtomicSet(&stream->running, 0);
+
+    if (stream->thread) SDL_WaitThread(stream->thread, NULL);
+    if (stream->file) fclose(stream->file);
+
+    SDL_DestroyMutex(stream->mutex);
+
+    cs_free_audio_source(stream->source);
+
+    free(stream->wav);
+    free(stream);
+}
+
+cs_audio_source_t* stream_get_source(stream_t* stream) { return stream->source; }
+
+void stream_rewind(stream_t* stream, bool loop)
+{
+    SDL_LockMutex(stream->mutex);
+
+    stream->read   = 0;
+    stream->filled = 0;
+    stream->loop   = loop;
+
+    stream->voice      = 0;
+    stream->lap        = 0;
+    stream->last_index = 0;
+
+    SDL_AtomicSet(&stream->cursor, 0);
+    SDL_AtomicSet(&stream->end, -1);
+
+    SDL_UnlockMutex(stream->mutex);
+
+    stream_fill(stream);
+}
+
+void stream_attach(stream_t* stream, uint64_t voice) { stream->voice = voice; }
+
+void stream_update(void)
+{
+    for (int i = 0; i < STREAM_MAX; ++i)
+    {
+        stream_t* stream = streams[i];
+
+        if (stream == NULL || stream->voice == 0) continue;
+
+        if (!audio_voice_is_active(stream->voice))
+        {
+            stream->voice = 0;
+            continue;
+        }
+
+        int index = audio_voice_get_index(stream->voice);
+
+        // a frame longer than the whole ring would miss
+        // a lap, the ring is sized well past that
+        if (index < stream->last_index) ++stream->lap;
+
+        stream->last_index = index;
+
+        int64_t frame = (int64_t)stream->lap * STREAM_RING_FRAMES + index;
+        int     end   = SDL_AtomicGet(&stream->end);
+
+        SDL_AtomicSet(&stream->cursor, (int)(frame / STREAM_CHUNK_FRAMES));
+
+        if (end >= 0 && frame >= end)
+        {
+            audio_voice_stop(stream->voice);
+            stream->voice = 0;
+            continue;
+        }
+
+        // without a thread, on the web or headless,
+        // the ring is topped up as the mix goes
+        if (stream->thread == NULL) stream_fill(stream);
+    }
+}
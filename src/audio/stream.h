@@ -0,0 +1,49 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______   ______  ______   ______   ______   __    __     //
+//  /\  ___\ /\__  _\/\  == \ /\  ___\ /\  __ \ /\ "-./  \    //
+//  \ \___  \\/_/\ \/\ \  __< \ \  __\ \ \  __ \\ \ \-./\ \   //
+//   \/\_____\  \ \_\ \ \_\ \_\\ \_____\\ \_\ \_\\ \_\ \ \_\  //
+//    \/_____/   \/_/  \/_/ /_/ \/_____/ \/_/\/_/ \/_/  \/_/  //
+//                                                            //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// audio/stream.h
+
+#ifndef AUDIO_STREAM_H
+#define AUDIO_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct stream_t          stream_t;
+    typedef struct cs_audio_source_t cs_audio_source_t;
+
+    // 16 bit pcm wavs are decoded a chunk at a time into a short
+    // ring, memory streams read the data in place until closed,
+    // chunks aren't resampled so other rates than the one asked
+    // for aren't opened and have to be loaded whole instead
+    stream_t* stream_open(const char* filepath, int rate);
+    stream_t* stream_open_memory(const void* data, size_t size, int rate);
+    void      stream_close(stream_t* stream);
+
+    // the ring source is always played looped, rewind
+    // refills it from the start before each play
+    cs_audio_source_t* stream_get_source(stream_t* stream);
+
+    void stream_rewind(stream_t* stream, bool loop);
+    void stream_attach(stream_t* stream, uint64_t voice);
+
+    // follows the play cursor of every attached stream
+    // and stops the ones that reached their end
+    void stream_update(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // AUDIO_STREAM_H
@@ -21,10 +21,12 @@ extern "C"
 {
 #endif
 
+    typedef struct atlas_sprite_t atlas_sprite_t;
+
     typedef struct
     {
-        int     frames[ANIMATION2D_MAX_FRAMES][4];
-        uint8_t frames_len;
+        atlas_sprite_t* frames[ANIMATION2D_MAX_FRAMES];
+        uint8_t         frames_len;
 
         bool    loop;
         uint8_t loops;
@@ -32,6 +32,9 @@ static shader_t* sprite_shader;
 static shader_t* scroll_shader;
 static shader_t* stars_shader;
 
+static shader_uniform_t scroll_scroll, scroll_height, scroll_matrix;
+static shader_uniform_t stars_scroll, stars_time, stars_resolution;
+
 void background_init(void)
 {
     texture_t* bg = texture_new_from_file("assets/textures/mid.png");
@@ -45,6 +48,13 @@ void background_init(void)
     content_find_shaders("sprite", &sprite_shader);
     content_find_shaders("scroll", &scroll_shader);
     content_find_shaders("stars", &stars_shader);
+
+    scroll_scroll    = shader_get_uniform(scroll_shader, "scroll");
+    scroll_height    = shader_get_uniform(scroll_shader, "height");
+    scroll_matrix    = shader_get_uniform(scroll_shader, "matrix");
+    stars_scroll     = shader_get_uniform(stars_shader, "scroll");
+    stars_time       = shader_get_uniform(stars_shader, "time");
+    stars_resolution = shader_get_uniform(stars_shader, "resolution");
 }
 
 void background_render(float dt, float total)
@@ -63,9 +73,9 @@ void background_render(float dt, float total)
     {
         renderer_shader_bind(stars_shader->id);
 
-        shader_apply_uniformf(stars_shader, "scroll", y);
-        shader_apply_uniformf(stars_shader, "time", total);
-        shader_apply_uniform2f(stars_shader, "resolution", (float[2]){GAME_WIDTH, GAME_HEIGHT});
+        shader_apply_uniformf(stars_shader, stars_scroll, y);
+        shader_apply_uniformf(stars_shader, stars_time, total);
+        shader_apply_uniform2f(stars_shader, stars_resolution, (float[2]){GAME_WIDTH, GAME_HEIGHT});
 
         quad_draw();
     }
@@ -74,9 +84,9 @@ void background_render(float dt, float total)
     {
         renderer_shader_bind(scroll_shader->id);
 
-        shader_apply_uniformf(scroll_shader, "scroll", mathf_max(y - GAME_HEIGHT / 2.0, -12800 + GAME_HEIGHT));
-        shader_apply_uniformf(scroll_shader, "height", GAME_HEIGHT);
-        shader_apply_uniform4x4f(scroll_shader, "matrix", matrix[0]);
+        shader_apply_uniformf(scroll_shader, scroll_scroll, mathf_max(y - GAME_HEIGHT / 2.0, -12800 + GAME_HEIGHT));
+        shader_apply_uniformf(scroll_shader, scroll_height, GAME_HEIGHT);
+        shader_apply_uniform4x4f(scroll_shader, scroll_matrix, matrix[0]);
 
         batch_set_texture(bg_id, bg_width, bg_height);
         batch_set_shader(scroll_shader->id);
@@ -31,9 +31,12 @@
 #define FRUIT_SIZE      (64)
 #define FRUIT_SIZE_HALF (FRUIT_SIZE / 2.0)
 
+POOL_DECLARE(fruit_t, fruits)
 POOL_DEFINE(fruit_t, fruits)
 
-static float fruit_texture_src[4];
+static fruits_pool_t fruits;
+
+static atlas_sprite_t* fruit_texture_src;
 
 static particle_system_t sparkles;
 
@@ -42,7 +45,7 @@ static void fruit_get_rect(fruit_t fruit, float rect[4]);
 
 void fruits_init(void)
 {
-    fruits_pool_new(FRUITS_NUM, POOL_FLAGS_ASSERT);
+    fruits_pool_new(&fruits, FRUITS_NUM, POOL_FLAGS_ASSERT);
 
     sparkles = (particle_system_t){
         .width  = FRUIT_SIZE,
@@ -62,24 +65,11 @@ void fruits_init(void)
         .scale_max_start = 21,
     };
 
-    int(*texture)[4];
-
-    content_find_textures("fruit1", &texture);
-
-    fruit_texture_src[0] = (*texture)[0];
-    fruit_texture_src[1] = (*texture)[1];
-    fruit_texture_src[2] = (*texture)[2];
-    fruit_texture_src[3] = (*texture)[3];
-
-    content_find_textures("sparkle", &texture);
-
-    sparkles.src[0] = (*texture)[0];
-    sparkles.src[1] = (*texture)[1];
-    sparkles.src[2] = (*texture)[2];
-    sparkles.src[3] = (*texture)[3];
+    content_find_textures("fruit1", &fruit_texture_src);
+    content_find_textures("sparkle", &sparkles.src);
 }
 
-void fruits_shutdown(void) { fruits_pool_delete(); }
+void fruits_shutdown(void) { fruits_pool_delete(&fruits); }
 
 static void fruit_get_center(fruit_t fruit, float* x, float* y)
 {
@@ -102,7 +92,7 @@ void fruits_update(float dt, float total)
 
     player_get_rect(player_rect);
 
-    POOL_LOOP_FORWARD(fruit_t, fruits, fruit)
+    POOL_LOOP_FORWARD(fruit_t, fruits, &fruits, fruit)
     {
         fruit_get_rect(*fruit, fruit_rect);
 
@@ -130,13 +120,13 @@ void fruits_update(float dt, float total)
         }
     }
 
-    for (int i = fruits_pool.count - 1; i >= 0; --i)
+    for (int i = fruits.count - 1; i >= 0; --i)
     {
-        fruit_t* fruit = &fruits_pool.data[i];
+        fruit_t* fruit = &fruits.data[i];
 
         if (fruit->scale <= 0)
         {
-            fruits_pool_remove(i);
+            fruits_pool_remove(&fruits, i);
         }
     }
 }
@@ -148,7 +138,7 @@ void fruits_render(float dt, float total)
 
     batch_set_tint(0xffffff, 1);
 
-    POOL_LOOP_FORWARD(fruit_t, fruits, fruit)
+    POOL_LOOP_FORWARD(fruit_t, fruits, &fruits, fruit)
     {
         fruit_get_rect(*fruit, rect);
 
@@ -169,7 +159,7 @@ void fruits_render(float dt, float total)
                 }
             );
             batch_set_fill(0xffffff, !fruit->active);
-            batch_draw_texture(fruit_texture_src, dst);
+            batch_draw_sprite(fruit_texture_src, dst);
             batch_set_rotation(0, VEC2_ZERO.xy);
         }
     }
@@ -177,7 +167,7 @@ void fruits_render(float dt, float total)
 
 void fruits_spawn(void)
 {
-    fruits_pool.count = 0;
+    fruits_pool_clear(&fruits);
 
     for (int i = 0; i < FRUITS_NUM; ++i)
     {
@@ -191,6 +181,6 @@ void fruits_spawn(void)
             .active = true,
         };
 
-        fruits_pool_insert(fruit);
+        fruits_pool_insert(&fruits, fruit);
     }
 }
@@ -21,6 +21,7 @@
 
 #include "platform/platform.h"
 #include "platform/content.h"
+#include "platform/trace.h"
 
 #include "graphics/quad.h"
 #include "graphics/color.h"
@@ -32,83 +33,303 @@
 
 #include "audio/audio.h"
 #include "audio/sound.h"
+#include "audio/render.h"
 
 #include "math/mathf.h"
 #include "math/matrix.h"
 
+#define GAME_LOAD_BUDGET (0.008)
+#define GAME_UPLOAD_ROWS (64)
+
+typedef enum LOAD_STAGE
+{
+    LOAD_STAGE_SHADERS,
+    LOAD_STAGE_CONTENT,
+    LOAD_STAGE_UPLOAD,
+    LOAD_STAGE_DONE,
+} LOAD_STAGE;
+
 static float sleep;
 
 static bool paused;
 
 static shader_t* sprite_shader;
+static shader_t* fill_shader;
 static shader_t* backbuffer_shader;
 
+static shader_uniform_t sprite_matrix, fill_matrix, backbuffer_paused;
+
+static atlas_t* atlas;
+static uint8_t* atlas_pixels;
 static uint32_t atlas_id;
 static int      atlas_width, atlas_height;
 
 static render_target_t render_target;
 
+static uint32_t base_id, top_id, paused_id;
+
+static LOAD_STAGE load_stage;
+static float      load_progress;
+static int        upload_row;
+
+static void game_start(void)
+{
+    TRACE_BEGIN("game_start");
+
+    base_id   = content_id_textures("base");
+    top_id    = content_id_textures("top");
+    paused_id = content_id_textures("paused");
+
+    camera_init();
+    player_init();
+    fruits_init();
+    quests_init();
+    particles_init();
+    background_init();
+
+    sound_t* ambience;
+
+    if (content_find_sounds("ambience", &ambience))
+    {
+        sound_set_limits(ambience, 1, SOUND_PRIORITY_HIGH);
+        sound_play(ambience, 1, true);
+    }
+
+#ifdef DEBUG
+    content_watch_start();
+#endif
+
+    TRACE_END();
+}
+
+static void game_load(double budget)
+{
+    uint64_t start     = platform_get_ticks();
+    double   frequency = 1.0 / (double)platform_get_ticks_frequency();
+
+    // the driver compiles while the rest starts up, the
+    // loading screen waits on the first frame they're done
+    if (load_stage == LOAD_STAGE_SHADERS)
+    {
+        if (!content_finish_shaders()) return;
+
+        content_find_shaders("sprite", &sprite_shader);
+        content_find_shaders("sprite_fill", &fill_shader);
+        content_find_shaders("backbuffer", &backbuffer_shader);
+
+        sprite_matrix     = shader_get_uniform(sprite_shader, "matrix");
+        fill_matrix       = shader_get_uniform(fill_shader, "matrix");
+        backbuffer_paused = shader_get_uniform(backbuffer_shader, "paused");
+
+        load_stage = LOAD_STAGE_CONTENT;
+    }
+
+    if (load_stage == LOAD_STAGE_CONTENT)
+    {
+        float sounds_progress;
+        float textures_progress;
+
+        bool sounds_loaded   = content_poll_sounds(budget / 2, &sounds_progress);
+        bool textures_loaded = content_poll_textures(budget / 2, &textures_progress);
+
+        load_progress = (sounds_progress + textures_progress) * 0.4f;
+
+        if (!sounds_loaded || !textures_loaded) return;
+
+        TRACE_BEGIN("game_load_atlas");
+
+        atlas_pack(atlas);
+        atlas_generate_texture(atlas, &atlas_pixels, &atlas_width, &atlas_height);
+
+        atlas_id   = renderer_texture_generate(NULL, atlas_width, atlas_height, TEXTURE_FORMAT_UBYTE);
+
+        TRACE_END();
+
+        upload_row = 0;
+        load_stage = LOAD_STAGE_UPLOAD;
+    }
+
+    // the page goes up in stripes so no
+    // frame stalls on the whole upload
+    while (upload_row < atlas_height && (platform_get_ticks() - start) * frequency < budget)
+    {
+        int rows = atlas_height - upload_row < GAME_UPLOAD_ROWS ? atlas_height - upload_row : GAME_UPLOAD_ROWS;
+
+        renderer_texture_subdata(atlas_id, atlas_pixels, atlas_width, (int[4]){0, upload_row, atlas_width, rows}, TEXTURE_FORMAT_UBYTE);
+
+        upload_row += rows;
+    }
+
+    load_progress = 0.8f + 0.2f * upload_row / (float)atlas_height;
+
+    if (upload_row < atlas_height) return;
+
+    // this runs inside the frame, the init lookups by
+    // name aren't per frame ones so the scope is ended
+    content_end_frame();
+    game_start();
+    content_begin_frame();
+
+    load_stage = LOAD_STAGE_DONE;
+}
+
+static void game_render_loading(void)
+{
+    static mat4_t matrix;
+
+    static int width, height;
+
+    platform_get_window_size(&width, &height);
+
+    mat4_identity(matrix);
+    mat4_orthographic(0, width, height, 0, matrix);
+
+    renderer_frame_buffer_unbind();
+    renderer_viewport(0, 0, width, height);
+    renderer_clear_color();
+
+    if (load_stage == LOAD_STAGE_SHADERS) return;
+
+    renderer_shader_bind(fill_shader->id);
+    shader_apply_uniform4x4f(fill_shader, fill_matrix, matrix[0]);
+
+    batch_begin();
+    batch_set_shader(fill_shader->id);
+    batch_set_texture(0, 1, 1);
+
+    batch_set_tint(RGB_WHITE, 0);
+    batch_set_fill(RGB_WHITE, 1);
+
+    batch_draw_texture(
+        (float[4]){0, 0, 1, 1},
+        (float[4]){
+            width * 0.25f,
+            height * 0.5f - 2,
+            width * 0.5f * load_progress,
+            4,
+        }
+    );
+
+    batch_end();
+}
+
 void game_init(void)
 {
-    atlas_t* atlas = atlas_new((atlas_desc_t){
+    TRACE_BEGIN("game_init");
+
+    atlas = atlas_new((atlas_desc_t){
         .resolution = 4096,
         .capacity   = 128,
         .expand     = 4,
         .border     = 4,
     });
 
-    uint8_t* pixels = NULL;
-
-    content_load_shaders();
-    content_load_sounds();
-    content_load_textures_ex(atlas);
-
-    atlas_pack(atlas);
-    atlas_generate_texture(atlas, &pixels, &atlas_width, &atlas_height);
+    content_mount();
 
-    atlas_id = renderer_texture_generate(pixels, atlas_width, atlas_height, TEXTURE_FORMAT_UBYTE);
-
-    atlas_delete(atlas);
+    // sounds decode to the device's rate,
+    // so it has to be known before they load
+    audio_init((audio_desc_t){
+        .sample_rate = 44100,
+        .buffer      = 1024,
+        .buffer_min  = 256,
+        .buffer_max  = 8192,
+        .adaptive    = true,
+    });
 
-    content_find_shaders("sprite", &sprite_shader);
-    content_find_shaders("backbuffer", &backbuffer_shader);
+    // shaders are needed for the loading screen, the
+    // rest arrives over the next frames in game_load
+    content_load_shaders();
+    content_load_sounds_async(NULL);
+    content_load_textures_async(atlas);
 
     render_target = render_target_generate(960, 1280, 1, (ATTACHMENT_TYPE[]){ATTACHMENT_UBYTE});
 
     batch_init(2048);
-    audio_init();
-    camera_init();
-    player_init();
-    fruits_init();
-    quests_init();
-    particles_init();
-    background_init();
-
-    sound_t* ambience;
-
-    content_find_sounds("ambience", &ambience);
-    sound_play(ambience, 1, true);
 
     batch_set_cull(CULL_BACK);
     batch_set_blend(BLEND_NON_PREMULTIPLIED);
+
+    load_stage = LOAD_STAGE_SHADERS;
+
+    TRACE_END();
 }
 
 void game_shutdown(void)
 {
+    // quitting during the load stops it where it is,
+    // only what got that far is released below
+    if (load_stage <= LOAD_STAGE_CONTENT)
+    {
+        content_cancel_sounds();
+        content_cancel_textures();
+    }
+
     render_target_delete(render_target);
 
-    fruits_shutdown();
-    particles_shutdown();
+    if (load_stage == LOAD_STAGE_DONE)
+    {
+        fruits_shutdown();
+        particles_shutdown();
+
+        content_watch_stop();
+    }
+
+    audio_stop();
 
     content_unload_shaders();
     content_unload_textures();
+    content_unload_sounds();
+
+    atlas_delete(atlas);
+
+    if (load_stage > LOAD_STAGE_CONTENT) renderer_texture_delete(atlas_id);
+
+    content_unmount();
 
     batch_shutdown();
     audio_shutdown();
 }
 
+static sound_t* game_find_sound(const char* name)
+{
+    sound_t* sound = NULL;
+
+    content_find_sounds(name, &sound);
+
+    return sound;
+}
+
+int game_render_audio(const char* commands, const char* filepath)
+{
+    content_mount();
+
+    audio_init((audio_desc_t){
+        .sample_rate = 44100,
+        .buffer      = 512,
+        .buffer_min  = 512,
+        .buffer_max  = 512,
+        .headless    = true,
+    });
+
+    content_load_sounds();
+
+    bool rendered = render_commands(commands, filepath, game_find_sound);
+
+    content_unload_sounds();
+    audio_shutdown();
+
+    content_unmount();
+
+    return rendered ? 0 : 1;
+}
+
 void game_update(double dt, double _)
 {
+    if (load_stage != LOAD_STAGE_DONE)
+    {
+        return;
+    }
+
     if (!platform_is_window_active())
     {
         paused = true;
@@ -123,6 +344,12 @@ void game_update(double dt, double _)
 
     audio_update(dt);
     camera_update(dt, total);
+
+    float x, y;
+
+    camera_get_position(&x, &y);
+    sound_set_listener(x, y);
+
     quests_update(dt, total);
 
     if (sleep > 0)
@@ -140,13 +367,19 @@ void game_render(double dt, double _)
 {
     static mat4_t matrix;
 
-    static int(*texture)[4];
-
     static float x, y;
     static int   width, height;
+    static int   dirty[4];
 
     static double total = 0;
 
+    if (load_stage != LOAD_STAGE_DONE)
+    {
+        game_load(GAME_LOAD_BUDGET);
+        game_render_loading();
+        return;
+    }
+
     if (platform_is_window_active())
     {
         total += dt;
@@ -154,6 +387,15 @@ void game_render(double dt, double _)
 
     platform_get_window_size(&width, &height);
 
+    content_watch_update(atlas);
+
+    // only the regions touched by textures added, removed
+    // or reloaded since the last frame are uploaded
+    if (atlas_flush(atlas, dirty))
+    {
+        renderer_texture_subdata(atlas_id, atlas_pixels, atlas_width, dirty, TEXTURE_FORMAT_UBYTE);
+    }
+
     player_get_position(&x, &y);
     camera_set_position(GAME_WIDTH / 2.0, y);
     camera_set_zoom(mathf_min(mathf_max(mathf_lerp(0.6, 1.0, (y + 36000) / 21600.0), 0.6), 1.0));
@@ -161,7 +403,7 @@ void game_render(double dt, double _)
     camera_get_matrix(matrix);
 
     renderer_shader_bind(sprite_shader->id);
-    shader_apply_uniform4x4f(sprite_shader, "matrix", matrix[0]);
+    shader_apply_uniform4x4f(sprite_shader, sprite_matrix, matrix[0]);
 
     renderer_frame_buffer_bind(render_target.frame_buffer);
     renderer_viewport(0, 0, GAME_WIDTH, GAME_HEIGHT);
@@ -178,15 +420,8 @@ void game_render(double dt, double _)
 
     if (y > -GAME_HEIGHT * 1.5)
     {
-        content_find_textures("base", &texture);
-
-        batch_draw_texture(
-            (float[4]){
-                (*texture)[0],
-                (*texture)[1],
-                (*texture)[2],
-                (*texture)[3],
-            },
+        batch_draw_sprite(
+            content_get_textures(base_id),
             (float[4]){
                 -8,
                 -1160,
@@ -198,15 +433,8 @@ void game_render(double dt, double _)
 
     if (y > -14000 && y < -10000)
     {
-        content_find_textures("top", &texture);
-
-        batch_draw_texture(
-            (float[4]){
-                (*texture)[0],
-                (*texture)[1],
-                (*texture)[2],
-                (*texture)[3],
-            },
+        batch_draw_sprite(
+            content_get_textures(top_id),
             (float[4]){
                 0,
                 -12800,
@@ -229,16 +457,9 @@ void game_render(double dt, double _)
 
     if (paused)
     {
-        content_find_textures("paused", &texture);
-
         batch_set_tint(RGB_WHITE, 1);
-        batch_draw_texture(
-            (float[4]){
-                (*texture)[0],
-                (*texture)[1],
-                (*texture)[2],
-                (*texture)[3],
-            },
+        batch_draw_sprite(
+            content_get_textures(paused_id),
             (float[4]){
                 GAME_WIDTH / 2.0 - 564 / 2.0,
                 y - 99 / 2.0,
@@ -269,7 +490,7 @@ void game_render(double dt, double _)
     renderer_shader_bind(backbuffer_shader->id);
     renderer_texture_bind(render_target.color_buffers[0], 0);
 
-    shader_apply_uniformi(backbuffer_shader, "paused", paused);
+    shader_apply_uniformi(backbuffer_shader, backbuffer_paused, paused);
 
     quad_draw();
 }
@@ -27,6 +27,10 @@ extern "C"
 
     void game_sleep(float ms);
 
+    // mixes a logged command sequence offline into a
+    // wav without a window, returns the exit code
+    int game_render_audio(const char* commands, const char* filepath);
+
 #ifdef __cplusplus
 }
 #endif
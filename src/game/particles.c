@@ -21,22 +21,25 @@
 
 #include "graphics/batch.h"
 
+POOL_DECLARE(particle_t, particles)
 POOL_DEFINE(particle_t, particles)
 
-void particles_init(void) { particles_pool_new(4096, POOL_FLAGS_RECYCLE); }
+static particles_pool_t particles;
 
-void particles_shutdown(void) { particles_pool_delete(); }
+void particles_init(void) { particles_pool_new(&particles, 4096, POOL_FLAGS_RECYCLE); }
+
+void particles_shutdown(void) { particles_pool_delete(&particles); }
 
 void particles_update(double dt, double total)
 {
-    POOL_LOOP_REVERSE(particle_t, particles, particle)
+    POOL_LOOP_REVERSE(particle_t, particles, &particles, particle)
     {
         particle->time -= dt;
 
         if (particle->time <= 0)
         {
-            size_t index = particle - particles_pool_begin();
-            particles_pool_remove(index);
+            size_t index = particle - particles_pool_begin(&particles);
+            particles_pool_remove(&particles, index);
             continue;
         }
 
@@ -47,7 +50,7 @@ void particles_update(double dt, double total)
 
 void particles_render(double dt, double total)
 {
-    POOL_LOOP_FORWARD(particle_t, particles, particle)
+    POOL_LOOP_FORWARD(particle_t, particles, &particles, particle)
     {
         float dst[4] = {
 
@@ -59,7 +62,7 @@ void particles_render(double dt, double total)
 
         batch_set_tint(0xffffff, particle->time / particle->total);
         batch_set_rotation(particle->rotation, (float[2]){particle->x + particle->scale / 2, particle->y + particle->scale / 2});
-        batch_draw_texture(particle->src, dst);
+        batch_draw_sprite(particle->src, dst);
         batch_set_rotation(0, VEC2_ZERO.xy);
     }
 }
@@ -102,10 +105,9 @@ static particle_t particle_spawn(particle_system_t system)
         .scale    = scale,
         .angle    = angle,
         .rotation = rotation,
+        .src      = system.src,
     };
 
-    memcpy(particle.src, system.src, 4 * sizeof(float));
-
     return particle;
 }
 
@@ -115,6 +117,6 @@ void particle_system_emit(particle_system_t system)
     {
         particle_t particle = particle_spawn(system);
 
-        particles_pool_insert(particle);
+        particles_pool_insert(&particles, particle);
     }
 }
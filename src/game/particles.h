@@ -20,6 +20,8 @@ extern "C"
 {
 #endif
 
+    typedef struct atlas_sprite_t atlas_sprite_t;
+
     enum
     {
         PARTICLE_SYSTEM_FLAGS_NONE = 0x0,
@@ -39,7 +41,7 @@ extern "C"
         float angle;
         float rotation;
 
-        float src[4];
+        atlas_sprite_t* src;
     } particle_t;
 
     typedef struct
@@ -68,7 +70,7 @@ extern "C"
         int rotation_min_start;
         int rotation_max_start;
 
-        float src[4];
+        atlas_sprite_t* src;
     } particle_system_t;
 
     void particles_init(void);
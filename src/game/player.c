@@ -93,7 +93,7 @@ static int player_state;
 static int player_facing;
 static int player_stars;
 
-static float star_texture[4];
+static atlas_sprite_t* star_texture;
 
 static sound_t* gust_sound;
 static sound_t* flap_sound;
@@ -101,6 +101,8 @@ static sound_t* land_sound;
 static sound_t* powerup_sound;
 static sound_t* sparkle_sound;
 
+static uint32_t note_ids[6];
+
 static particle_system_t dust_particles;
 static particle_system_t feathers_particles;
 
@@ -136,144 +138,17 @@ void player_init(void)
 
     player_animation = &player_animation_idle;
 
-    int(*texture)[4];
-
-    content_find_textures("idle", &texture);
-
-    memcpy(
-        player_animation_idle.frames[0],
-        (int[4]){
-            (*texture)[0],
-            (*texture)[1],
-            (*texture)[2],
-            (*texture)[3],
-        },
-        4 * sizeof(int)
-    );
-
-    content_find_textures("walk1", &texture);
-
-    memcpy(
-        player_animation_walk.frames[0],
-        (int[4]){
-            (*texture)[0],
-            (*texture)[1],
-            (*texture)[2],
-            (*texture)[3],
-        },
-        4 * sizeof(int)
-    );
-
-    content_find_textures("walk2", &texture);
-
-    memcpy(
-        player_animation_walk.frames[1],
-        (int[4]){
-            (*texture)[0],
-            (*texture)[1],
-            (*texture)[2],
-            (*texture)[3],
-        },
-        4 * sizeof(int)
-    );
-
-    content_find_textures("jump1", &texture);
-
-    memcpy(
-        player_animation_jump.frames[0],
-        (int[4]){
-            (*texture)[0],
-            (*texture)[1],
-            (*texture)[2],
-            (*texture)[3],
-        },
-        4 * sizeof(int)
-    );
-
-    content_find_textures("jump2", &texture);
-
-    memcpy(
-        player_animation_jump.frames[1],
-        (int[4]){
-            (*texture)[0],
-            (*texture)[1],
-            (*texture)[2],
-            (*texture)[3],
-        },
-        4 * sizeof(int)
-    );
-
-    content_find_textures("jump3", &texture);
-
-    memcpy(
-        player_animation_jump.frames[2],
-        (int[4]){
-            (*texture)[0],
-            (*texture)[1],
-            (*texture)[2],
-            (*texture)[3],
-        },
-        4 * sizeof(int)
-    );
-
-    content_find_textures("jump2", &texture);
-
-    memcpy(
-        player_animation_fall.frames[0],
-        (int[4]){
-            (*texture)[0],
-            (*texture)[1],
-            (*texture)[2],
-            (*texture)[3],
-        },
-        4 * sizeof(int)
-    );
-
-    content_find_textures("fall1", &texture);
-
-    memcpy(
-        player_animation_fall.frames[1],
-        (int[4]){
-            (*texture)[0],
-            (*texture)[1],
-            (*texture)[2],
-            (*texture)[3],
-        },
-        4 * sizeof(int)
-    );
-
-    content_find_textures("fall2", &texture);
-
-    memcpy(
-        player_animation_fall.frames[2],
-        (int[4]){
-            (*texture)[0],
-            (*texture)[1],
-            (*texture)[2],
-            (*texture)[3],
-        },
-        4 * sizeof(int)
-    );
-
-    content_find_textures("fall1", &texture);
-
-    memcpy(
-        player_animation_glide.frames[0],
-        (int[4]){
-            (*texture)[0],
-            (*texture)[1],
-            (*texture)[2],
-            (*texture)[3],
-        },
-        4 * sizeof(int)
-    );
-
-    content_find_textures("star", &texture);
-
-    star_texture[0] = (*texture)[0];
-    star_texture[1] = (*texture)[1];
-    star_texture[2] = (*texture)[2];
-    star_texture[3] = (*texture)[3];
+    content_find_textures("idle", &player_animation_idle.frames[0]);
+    content_find_textures("walk1", &player_animation_walk.frames[0]);
+    content_find_textures("walk2", &player_animation_walk.frames[1]);
+    content_find_textures("jump1", &player_animation_jump.frames[0]);
+    content_find_textures("jump2", &player_animation_jump.frames[1]);
+    content_find_textures("jump3", &player_animation_jump.frames[2]);
+    content_find_textures("jump2", &player_animation_fall.frames[0]);
+    content_find_textures("fall1", &player_animation_fall.frames[1]);
+    content_find_textures("fall2", &player_animation_fall.frames[2]);
+    content_find_textures("fall1", &player_animation_glide.frames[0]);
+    content_find_textures("star", &star_texture);
 
     feathers_particles = (particle_system_t){
         .width  = 64,
@@ -317,25 +192,31 @@ void player_init(void)
         .rotation_max_start = 360,
     };
 
-    content_find_textures("feather", &texture);
-
-    feathers_particles.src[0] = (*texture)[0];
-    feathers_particles.src[1] = (*texture)[1];
-    feathers_particles.src[2] = (*texture)[2];
-    feathers_particles.src[3] = (*texture)[3];
-
-    content_find_textures("dust", &texture);
-
-    dust_particles.src[0] = (*texture)[0];
-    dust_particles.src[1] = (*texture)[1];
-    dust_particles.src[2] = (*texture)[2];
-    dust_particles.src[3] = (*texture)[3];
+    content_find_textures("feather", &feathers_particles.src);
+    content_find_textures("dust", &dust_particles.src);
 
     content_find_sounds("gust", &gust_sound);
     content_find_sounds("flap", &flap_sound);
     content_find_sounds("land", &land_sound);
     content_find_sounds("powerup", &powerup_sound);
     content_find_sounds("sparkle", &sparkle_sound);
+
+    note_ids[0] = content_id_sounds("note1");
+    note_ids[1] = content_id_sounds("note2");
+    note_ids[2] = content_id_sounds("note3");
+    note_ids[3] = content_id_sounds("note4");
+    note_ids[4] = content_id_sounds("note5");
+    note_ids[5] = content_id_sounds("note6");
+
+    // flaps and pickups repeat quickly, the newest
+    // few instances are the ones worth hearing
+    sound_set_limits(gust_sound, 2, SOUND_PRIORITY_LOW);
+    sound_set_limits(flap_sound, 2, SOUND_PRIORITY_NORMAL);
+    sound_set_limits(land_sound, 1, SOUND_PRIORITY_NORMAL);
+    sound_set_limits(sparkle_sound, 3, SOUND_PRIORITY_LOW);
+    sound_set_limits(powerup_sound, 2, SOUND_PRIORITY_HIGH);
+
+    for (int i = 0; i < 6; ++i) sound_set_limits(content_get_sounds(note_ids[i]), 2, SOUND_PRIORITY_NORMAL);
 }
 
 static void player_set_squish(float x, float y)
@@ -344,6 +225,13 @@ static void player_set_squish(float x, float y)
     player_scale.y = y;
 }
 
+// the player's sounds come from where it is, so
+// what happens off screen fades with the distance
+static void player_play_sound(sound_t* sound, float volume)
+{
+    sound_play_at(sound, volume, false, player_position.x + PLAYER_SIZE_HALF, player_position.y + PLAYER_SIZE_HALF);
+}
+
 static void player_update_squish(float dt) { vec2_lerp(player_scale, VEC2_ONE, dt * 6, &player_scale); }
 
 static void player_jump(void)
@@ -356,7 +244,7 @@ static void player_jump(void)
         player_stars /= 2;
 
         camera_shake(0.8, 3);
-        sound_play(gust_sound, 1, false);
+        player_play_sound(gust_sound, 1);
     }
     else
     {
@@ -386,7 +274,7 @@ static void player_jump(void)
     feathers_particles.amount = mathi_random(3, 5);
 
     particle_system_emit(feathers_particles);
-    sound_play(flap_sound, 2, false);
+    player_play_sound(flap_sound, 2);
 }
 
 static void player_update_state(float dt)
@@ -535,7 +423,7 @@ void player_update(float dt, float total)
 
             particle_system_emit(dust_particles);
             camera_shake(time, amount);
-            sound_play(land_sound, 1, false);
+            player_play_sound(land_sound, 1);
         }
 
         player_state = PLAYER_GROUND;
@@ -622,7 +510,7 @@ static void player_render_stars(float dt, float total)
             };
 
             batch_set_tint(color, 1 - j / (float)3);
-            batch_draw_texture(star_texture, dst);
+            batch_draw_sprite(star_texture, dst);
         }
 
         if (player_stars >= PLAYER_STARS_MAX)
@@ -640,11 +528,11 @@ static void player_render_stars(float dt, float total)
             };
 
             batch_set_tint(color, 1 - t);
-            batch_draw_texture(star_texture, dst);
+            batch_draw_sprite(star_texture, dst);
         }
 
         batch_set_tint(color, 1);
-        batch_draw_texture(star_texture, dst);
+        batch_draw_sprite(star_texture, dst);
     }
 }
 
@@ -662,13 +550,8 @@ void player_render(float dt, float total)
 
     uint8_t frame = animation_get_frame_index(*player_animation);
 
-    batch_draw_texture(
-        (float[4]){
-            player_animation->frames[frame][0],
-            player_animation->frames[frame][1],
-            player_animation->frames[frame][2],
-            player_animation->frames[frame][3],
-        },
+    batch_draw_sprite(
+        player_animation->frames[frame],
         (float[4]){
             player_position.x + PLAYER_RENDER_SIZE * 0.5 - PLAYER_RENDER_SIZE * 0.5 * player_scale.x - PLAYER_SIZE_HALF,
             player_position.y + PLAYER_RENDER_SIZE - PLAYER_RENDER_SIZE * player_scale.y - PLAYER_SIZE_HALF * 2,
@@ -702,27 +585,17 @@ void player_add_star(void)
     static int cycle;
     cycle = (cycle + 1) % 6;
 
-    sound_t* note;
-
-    switch (cycle)
-    {
-        case 0: content_find_sounds("note1", &note); break;
-        case 1: content_find_sounds("note2", &note); break;
-        case 2: content_find_sounds("note3", &note); break;
-        case 3: content_find_sounds("note4", &note); break;
-        case 4: content_find_sounds("note5", &note); break;
-        case 5: content_find_sounds("note6", &note); break;
-    }
+    sound_t* note = content_get_sounds(note_ids[cycle]);
 
-    sound_play(sparkle_sound, 1, false);
+    player_play_sound(sparkle_sound, 1);
 
     if (player_stars + 1 == PLAYER_STARS_MAX)
     {
-        sound_play(powerup_sound, 1, false);
+        player_play_sound(powerup_sound, 1);
     }
     else
     {
-        sound_play(note, 1, false);
+        player_play_sound(note, 1);
     }
 
     player_stars = mathf_min(player_stars + 1, PLAYER_STARS_MAX);
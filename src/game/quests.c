@@ -43,8 +43,8 @@ static bool completed[QUESTS_NUM];
 
 static float scales[QUESTS_NUM];
 
-static float indicator_texture[4];
-static float(textures[QUESTS_NUM])[4];
+static atlas_sprite_t* indicator_texture;
+static atlas_sprite_t* textures[QUESTS_NUM];
 
 static vec2_t positions[QUESTS_NUM] = {
     [QUEST_POSTCARD] = {.x = 800, .y = -2560},
@@ -67,46 +67,16 @@ void quests_init(void)
         completed[i] = false;
     }
 
-    int(*texture)[4];
-    int(*texture1)[4];
-    int(*texture2)[4];
-    int(*texture3)[4];
-    int(*texture4)[4];
-
-    content_find_textures("indicator", &texture);
-
-    content_find_textures("lost1", &texture1);
-    content_find_textures("lost1", &texture1);
-    content_find_textures("lost2", &texture2);
-    content_find_textures("lost3", &texture3);
-    content_find_textures("lost4", &texture4);
-
-    indicator_texture[0] = (*texture)[0];
-    indicator_texture[1] = (*texture)[1];
-    indicator_texture[2] = (*texture)[2];
-    indicator_texture[3] = (*texture)[3];
-
-    textures[QUEST_POSTCARD][0] = (*texture1)[0];
-    textures[QUEST_POSTCARD][1] = (*texture1)[1];
-    textures[QUEST_POSTCARD][2] = (*texture1)[2];
-    textures[QUEST_POSTCARD][3] = (*texture1)[3];
-
-    textures[QUEST_PACKAGE][0] = (*texture2)[0];
-    textures[QUEST_PACKAGE][1] = (*texture2)[1];
-    textures[QUEST_PACKAGE][2] = (*texture2)[2];
-    textures[QUEST_PACKAGE][3] = (*texture2)[3];
-
-    textures[QUEST_BOTTLE][0] = (*texture3)[0];
-    textures[QUEST_BOTTLE][1] = (*texture3)[1];
-    textures[QUEST_BOTTLE][2] = (*texture3)[2];
-    textures[QUEST_BOTTLE][3] = (*texture3)[3];
-
-    textures[QUEST_LETTER][0] = (*texture4)[0];
-    textures[QUEST_LETTER][1] = (*texture4)[1];
-    textures[QUEST_LETTER][2] = (*texture4)[2];
-    textures[QUEST_LETTER][3] = (*texture4)[3];
+    content_find_textures("indicator", &indicator_texture);
+
+    content_find_textures("lost1", &textures[QUEST_POSTCARD]);
+    content_find_textures("lost2", &textures[QUEST_PACKAGE]);
+    content_find_textures("lost3", &textures[QUEST_BOTTLE]);
+    content_find_textures("lost4", &textures[QUEST_LETTER]);
 
     content_find_sounds("quest", &quest_complete_sound);
+
+    sound_set_limits(quest_complete_sound, 1, SOUND_PRIORITY_HIGH);
 }
 
 static void quest_get_rect(size_t index, float rect[4])
@@ -169,7 +139,7 @@ static void quest_render_indicator(size_t index, float dt, float total)
             y + (GAME_HEIGHT / zoom / 2.0 - 16) * (position.y > y ? 1 : -1) + 4,
         }
     );
-    batch_draw_texture(
+    batch_draw_sprite(
         indicator_texture,
         (float[4]){
             position.x + 8,
@@ -187,7 +157,7 @@ static void quest_render_indicator(size_t index, float dt, float total)
             y + (GAME_HEIGHT / zoom / 2.0 - 16) * (position.y > y ? 1 : -1),
         }
     );
-    batch_draw_texture(
+    batch_draw_sprite(
         indicator_texture,
         (float[4]){
             position.x,
@@ -197,7 +167,7 @@ static void quest_render_indicator(size_t index, float dt, float total)
         }
     );
     batch_set_rotation(0, VEC2_ZERO.xy);
-    batch_draw_texture(
+    batch_draw_sprite(
         textures[index],
         (float[4]){
             position.x + QUEST_SIZE_HALF / 2.0,
@@ -235,7 +205,7 @@ void quests_render(float dt, float total)
             );
             batch_set_tint(RGB_WHITE, 1);
             batch_set_fill(RGB_WHITE, completed[i]);
-            batch_draw_texture(textures[i], dst);
+            batch_draw_sprite(textures[i], dst);
             batch_set_rotation(0, VEC2_ZERO.xy);
         }
         else if (!completed[i])
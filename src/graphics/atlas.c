@@ -9,18 +9,28 @@
 // graphics/atlas.c
 
 #include <assert.h>
+#include <float.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "graphics/atlas.h"
 
-#define RGBA_CHANNELS (4)
+#include "platform/trace.h"
+
+#define RGBA_CHANNELS      (4)
+
+#define HULL_MIN_AREA      (256 * 256)
+#define HULL_MAX_COVERAGE  (0.85)
+#define HULL_EPSILON       (0.001f)
 
 typedef struct
 {
-    int      rect[4];
-    uint32_t buffer_index;
+    atlas_sprite_t sprite;
+    size_t         hash;
+    uint32_t       buffer_index;
+    uint32_t       refs;  // textures with the same pixels share a node
 } atlas_node_t;
 
 struct atlas_t
@@ -28,12 +38,18 @@ struct atlas_t
     size_t capacity;
     size_t count;
 
-    size_t*        hashes;
     atlas_node_t** nodes;
 
+    int (*spaces)[4];
+    size_t spaces_len;
+    size_t spaces_capacity;
+
     uint8_t* buffer;
     uint32_t buffer_index;
 
+    uint8_t* page;
+    int      dirty[4];
+
     uint8_t  expand;
     uint8_t  border;
     uint16_t width;
@@ -43,8 +59,8 @@ struct atlas_t
 
 static int atlas_compare_area(const void* a, const void* b)
 {
-    int a_height = (*(atlas_node_t**)a)->rect[3];
-    int b_height = (*(atlas_node_t**)b)->rect[3];
+    int a_height = (*(atlas_node_t**)a)->sprite.rect[3];
+    int b_height = (*(atlas_node_t**)b)->sprite.rect[3];
 
     return b_height - a_height;
 }
@@ -56,11 +72,444 @@ static size_t atlas_generate_hash(uint8_t* pixels, size_t len)
     return hash;
 }
 
-static bool atlas_check_hash_unique(size_t hash, size_t* hashes, size_t len)
+static atlas_node_t* atlas_find_hash(atlas_t* atlas, size_t hash)
+{
+    for (size_t i = 0; i < atlas->count; ++i)
+        if (hash == atlas->nodes[i]->hash) return atlas->nodes[i];
+    return NULL;
+}
+
+static void atlas_get_opaque_bounds(uint8_t* pixels, int width, int height, int bounds[4])
+{
+    int min_x = width;
+    int min_y = height;
+    int max_x = -1;
+    int max_y = -1;
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            if (pixels[(x + y * width) * RGBA_CHANNELS + 3] == 0) continue;
+
+            if (x < min_x) min_x = x;
+            if (x > max_x) max_x = x;
+            if (y < min_y) min_y = y;
+            if (y > max_y) max_y = y;
+        }
+    }
+
+    // fully transparent images still need a
+    // non-empty rect for the packer to place
+    if (max_x < 0)
+    {
+        min_x = min_y = max_x = max_y = 0;
+    }
+
+    bounds[0] = min_x;
+    bounds[1] = min_y;
+    bounds[2] = max_x - min_x + 1;
+    bounds[3] = max_y - min_y + 1;
+}
+
+static int atlas_compare_point(const void* a, const void* b)
+{
+    const float* p = (const float*)a;
+    const float* q = (const float*)b;
+
+    if (p[0] != q[0]) return p[0] < q[0] ? -1 : 1;
+    if (p[1] != q[1]) return p[1] < q[1] ? -1 : 1;
+    return 0;
+}
+
+static float atlas_cross(const float o[2], const float a[2], const float b[2])
 {
+    return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0]);
+}
+
+static float atlas_polygon_area(float (*polygon)[2], size_t len)
+{
+    float area = 0;
+
     for (size_t i = 0; i < len; ++i)
-        if (hash == hashes[i]) return false;
-    return true;
+    {
+        const float* a = polygon[i];
+        const float* b = polygon[(i + 1) % len];
+
+        area += a[0] * b[1] - b[0] * a[1];
+    }
+
+    return fabsf(area) * 0.5f;
+}
+
+static size_t atlas_build_hull(float (*points)[2], size_t len, float (*hull)[2])
+{
+    // andrew's monotone chain, hull is written
+    // counter-clockwise without collinear points
+    qsort(points, len, 2 * sizeof(float), atlas_compare_point);
+
+    size_t k = 0;
+
+    for (size_t i = 0; i < len; ++i)
+    {
+        while (k >= 2 && atlas_cross(hull[k - 2], hull[k - 1], points[i]) <= 0) --k;
+        memcpy(hull[k++], points[i], 2 * sizeof(float));
+    }
+
+    for (size_t i = len - 1, t = k + 1; i-- > 0;)
+    {
+        while (k >= t && atlas_cross(hull[k - 2], hull[k - 1], points[i]) <= 0) --k;
+        memcpy(hull[k++], points[i], 2 * sizeof(float));
+    }
+
+    return k - 1;
+}
+
+static size_t atlas_reduce_hull(float (*hull)[2], size_t len, float width, float height)
+{
+    // collapse the edge whose removal adds the least area:
+    // its neighbours are extended until they meet, which
+    // keeps the polygon convex and containing every pixel
+    while (len > ATLAS_HULL_MAX_VERTICES)
+    {
+        size_t best      = len;
+        float  best_area = FLT_MAX;
+        float  best_point[2];
+
+        for (size_t i = 0; i < len; ++i)
+        {
+            const float* a = hull[(i + len - 1) % len];
+            const float* b = hull[i];
+            const float* c = hull[(i + 1) % len];
+            const float* d = hull[(i + 2) % len];
+
+            float r[2] = {b[0] - a[0], b[1] - a[1]};
+            float s[2] = {c[0] - d[0], c[1] - d[1]};
+
+            float denom = r[0] * s[1] - r[1] * s[0];
+
+            if (fabsf(denom) < HULL_EPSILON) continue;
+
+            float t = ((d[0] - a[0]) * s[1] - (d[1] - a[1]) * s[0]) / denom;
+            float u = ((d[0] - a[0]) * r[1] - (d[1] - a[1]) * r[0]) / denom;
+
+            if (t < 1 || u < 1) continue;
+
+            float q[2] = {a[0] + r[0] * t, a[1] + r[1] * t};
+
+            // uvs outside the trimmed rect would sample neighbouring sprites
+            if (q[0] < -HULL_EPSILON || q[0] > width + HULL_EPSILON) continue;
+            if (q[1] < -HULL_EPSILON || q[1] > height + HULL_EPSILON) continue;
+
+            float area = fabsf(atlas_cross(b, q, c)) * 0.5f;
+
+            if (area < best_area)
+            {
+                best          = i;
+                best_area     = area;
+                best_point[0] = fminf(fmaxf(q[0], 0), width);
+                best_point[1] = fminf(fmaxf(q[1], 0), height);
+            }
+        }
+
+        if (best == len) break;
+
+        size_t next = (best + 1) % len;
+
+        memcpy(hull[best], best_point, 2 * sizeof(float));
+        memmove(hull[next], hull[next + 1], (len - next - 1) * 2 * sizeof(float));
+
+        --len;
+    }
+
+    return len;
+}
+
+static void atlas_generate_hull(atlas_sprite_t* sprite, uint8_t* pixels, int width)
+{
+    sprite->hull_len = 0;
+
+    int w = sprite->rect[2];
+    int h = sprite->rect[3];
+
+    if (w * h < HULL_MIN_AREA)
+    {
+        return;
+    }
+
+    float(*points)[2] = malloc(h * 4 * 2 * sizeof(float));
+    float(*hull)[2]   = malloc((h * 8 + 1) * 2 * sizeof(float));
+
+    assert(points);
+    assert(hull);
+
+    size_t len = 0;
+
+    // the outermost opaque pixel corners of
+    // each row are enough to span the hull
+    for (int y = 0; y < h; ++y)
+    {
+        uint8_t* row = pixels + ((sprite->trim[0]) + (sprite->trim[1] + y) * width) * RGBA_CHANNELS;
+
+        int left  = -1;
+        int right = -1;
+
+        for (int x = 0; x < w; ++x)
+        {
+            if (row[x * RGBA_CHANNELS + 3] == 0) continue;
+
+            if (left < 0) left = x;
+            right = x;
+        }
+
+        if (left < 0) continue;
+
+        float corners[4][2] = {
+            {left, y},
+            {left, y + 1},
+            {right + 1, y},
+            {right + 1, y + 1},
+        };
+
+        memcpy(points[len], corners, 4 * 2 * sizeof(float));
+        len += 4;
+    }
+
+    len = len >= 3 ? atlas_build_hull(points, len, hull) : 0;
+    len = atlas_reduce_hull(hull, len, w, h);
+
+    bool is_reduced   = len >= 3 && len <= ATLAS_HULL_MAX_VERTICES;
+    bool is_efficient = atlas_polygon_area(hull, len) < w * h * HULL_MAX_COVERAGE;
+
+    if (is_reduced && is_efficient)
+    {
+        memcpy(sprite->hull, hull, len * 2 * sizeof(float));
+        sprite->hull_len = (uint8_t)len;
+    }
+
+    free(points);
+    free(hull);
+}
+
+static void atlas_push_space(atlas_t* atlas, const int space[4])
+{
+    if (atlas->spaces_len == atlas->spaces_capacity)
+    {
+        atlas->spaces_capacity *= 2;
+        atlas->spaces = realloc(atlas->spaces, atlas->spaces_capacity * 4 * sizeof(int));
+
+        assert(atlas->spaces);
+    }
+
+    memcpy(atlas->spaces[atlas->spaces_len++], space, 4 * sizeof(int));
+}
+
+static void atlas_remove_space(atlas_t* atlas, size_t index)
+{
+    if (index < --atlas->spaces_len) memcpy(atlas->spaces[index], atlas->spaces[atlas->spaces_len], 4 * sizeof(int));
+}
+
+static void atlas_free_space(atlas_t* atlas, int space[4])
+{
+    // the trailing padding of a region
+    // may reach past the packed page
+    if (space[0] + space[2] > atlas->width) space[2] = atlas->width - space[0];
+    if (space[1] + space[3] > atlas->height) space[3] = atlas->height - space[1];
+
+    if (space[2] <= 0 || space[3] <= 0) return;
+
+    bool merged = true;
+
+    // only spaces sharing a whole edge are merged,
+    // anything else is kept as a separate space
+    while (merged)
+    {
+        merged = false;
+
+        for (size_t i = 0; i < atlas->spaces_len; ++i)
+        {
+            const int* other = atlas->spaces[i];
+
+            bool same_row    = other[1] == space[1] && other[3] == space[3];
+            bool same_column = other[0] == space[0] && other[2] == space[2];
+
+            if (same_row && (other[0] + other[2] == space[0] || space[0] + space[2] == other[0]))
+            {
+                space[0] = other[0] < space[0] ? other[0] : space[0];
+                space[2] += other[2];
+            }
+            else if (same_column && (other[1] + other[3] == space[1] || space[1] + space[3] == other[1]))
+            {
+                space[1] = other[1] < space[1] ? other[1] : space[1];
+                space[3] += other[3];
+            }
+            else
+            {
+                continue;
+            }
+
+            atlas_remove_space(atlas, i);
+
+            merged = true;
+            break;
+        }
+    }
+
+    atlas_push_space(atlas, space);
+}
+
+static void atlas_clip_spaces(atlas_t* atlas)
+{
+    for (size_t i = atlas->spaces_len; i-- > 0;)
+    {
+        int* space = atlas->spaces[i];
+
+        if (space[0] + space[2] > atlas->width) space[2] = atlas->width - space[0];
+        if (space[1] + space[3] > atlas->height) space[3] = atlas->height - space[1];
+
+        if (space[2] <= 0 || space[3] <= 0) atlas_remove_space(atlas, i);
+    }
+}
+
+static bool atlas_place(atlas_t* atlas, int rect[4])
+{
+    int padding = atlas->expand * 2 + atlas->border;
+
+    for (size_t j = atlas->spaces_len; j-- > 0;)
+    {
+        int space[4];
+
+        memcpy(space, atlas->spaces[j], 4 * sizeof(int));
+
+        int w = rect[2] + padding;
+        int h = rect[3] + padding;
+
+        // check if image too large for space
+        if (w > space[2] || h > space[3]) continue;
+
+        // add image to space's top-left
+        // |-------|-------|
+        // |  box  |       |
+        // |_______|       |
+        // |         space |
+        // |_______________|
+
+        rect[0] = space[0] + atlas->expand;
+        rect[1] = space[1] + atlas->expand;
+
+        if (w == space[2] && h == space[3])
+        {
+            // remove space if perfect fit
+            // |---------------|
+            // |               |
+            // |      box      |
+            // |               |
+            // |_______________|
+
+            atlas_remove_space(atlas, j);
+        }
+        else if (h == space[3])
+        {
+            // space matches image height
+            // move space right and cut off width
+            // |-------|---------------|
+            // |  box  | updated space |
+            // |_______|_______________|
+
+            atlas->spaces[j][0] += w;
+            atlas->spaces[j][2] -= w;
+        }
+        else if (w == space[2])
+        {
+            // space matches image width
+            // move space down and cut off height
+            // |---------------|
+            // |      box      |
+            // |_______________|
+            // | updated space |
+            // |_______________|
+
+            atlas->spaces[j][1] += h;
+            atlas->spaces[j][3] -= h;
+        }
+        else
+        {
+            // split width and height
+            // difference into two new spaces
+            // |-------|-----------|
+            // |  box  | new space |
+            // |_______|___________|
+            // | updated space     |
+            // |___________________|
+
+            int new_space[4] = {
+                space[0] + w,
+                space[1],
+                space[2] - w,
+                h,
+            };
+
+            atlas->spaces[j][1] += h;
+            atlas->spaces[j][3] -= h;
+
+            atlas_push_space(atlas, new_space);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+static void atlas_mark_dirty(atlas_t* atlas, int x, int y, int width, int height)
+{
+    int* dirty = atlas->dirty;
+
+    if (dirty[2] == 0 || dirty[3] == 0)
+    {
+        dirty[0] = x;
+        dirty[1] = y;
+        dirty[2] = width;
+        dirty[3] = height;
+
+        return;
+    }
+
+    int x1 = dirty[0] + dirty[2] > x + width ? dirty[0] + dirty[2] : x + width;
+    int y1 = dirty[1] + dirty[3] > y + height ? dirty[1] + dirty[3] : y + height;
+
+    dirty[0] = dirty[0] < x ? dirty[0] : x;
+    dirty[1] = dirty[1] < y ? dirty[1] : y;
+    dirty[2] = x1 - dirty[0];
+    dirty[3] = y1 - dirty[1];
+}
+
+static void atlas_blit(atlas_t* atlas, const int rect[4], const uint8_t* src_buffer, int stride)
+{
+    uint8_t* dst_buffer = atlas->page;
+
+    for (int y = -atlas->expand * RGBA_CHANNELS; y < (int)(rect[3] + atlas->expand) * RGBA_CHANNELS; y += RGBA_CHANNELS)
+    {
+        for (int x = -atlas->expand * RGBA_CHANNELS; x < (int)(rect[2] + atlas->expand) * RGBA_CHANNELS; x += RGBA_CHANNELS)
+        {
+            int src_x = x < 0 ? 0 : x > (rect[2] - 1) * RGBA_CHANNELS ? (rect[2] - 1) * RGBA_CHANNELS : x;
+            int src_y = y < 0 ? 0 : y > (rect[3] - 1) * RGBA_CHANNELS ? (rect[3] - 1) * RGBA_CHANNELS : y;
+
+            int dst_pixel_index = rect[0] * RGBA_CHANNELS + x + (rect[1] * RGBA_CHANNELS + y) * atlas->width;
+            int src_pixel_index = src_x + src_y * stride;
+
+            dst_buffer[dst_pixel_index + 0] = src_buffer[src_pixel_index + 0];
+            dst_buffer[dst_pixel_index + 1] = src_buffer[src_pixel_index + 1];
+            dst_buffer[dst_pixel_index + 2] = src_buffer[src_pixel_index + 2];
+            dst_buffer[dst_pixel_index + 3] = src_buffer[src_pixel_index + 3];
+        }
+    }
+
+    atlas_mark_dirty(atlas,
+                     rect[0] - atlas->expand,
+                     rect[1] - atlas->expand,
+                     rect[2] + atlas->expand * 2,
+                     rect[3] + atlas->expand * 2);
 }
 
 atlas_t* atlas_new(atlas_desc_t desc)
@@ -75,88 +524,252 @@ atlas_t* atlas_new(atlas_desc_t desc)
     atlas->expand     = desc.expand;
     atlas->border     = desc.border;
     atlas->resolution = desc.resolution;
+    atlas->width      = 0u;
+    atlas->height     = 0u;
 
     atlas->capacity = desc.capacity;
     atlas->count    = 0u;
 
-    atlas->buffer_index = 0u;
-    atlas->buffer       = (uint8_t*)malloc(desc.resolution * desc.resolution * RGBA_CHANNELS * sizeof(uint8_t));
-    atlas->hashes       = (size_t*)malloc(sizeof(size_t) * desc.capacity);
-    atlas->nodes        = (atlas_node_t**)malloc(sizeof(atlas_node_t*) * desc.capacity);
+    atlas->buffer_index    = 0u;
+    atlas->buffer          = (uint8_t*)malloc(desc.resolution * desc.resolution * RGBA_CHANNELS * sizeof(uint8_t));
+    atlas->nodes           = (atlas_node_t**)malloc(sizeof(atlas_node_t*) * desc.capacity);
+    atlas->spaces_len      = 0u;
+    atlas->spaces_capacity = desc.capacity;
+    atlas->spaces          = malloc(desc.capacity * 4 * sizeof(int));
+    atlas->page            = NULL;
 
     assert(atlas->buffer);
-    assert(atlas->hashes);
     assert(atlas->nodes);
+    assert(atlas->spaces);
+
+    memset(atlas->dirty, 0, 4 * sizeof(int));
+
+    int start_space[4] = {
+        0,
+        0,
+        atlas->resolution,
+        atlas->resolution,
+    };
+
+    atlas_push_space(atlas, start_space);
 
     return atlas;
 }
 
 void atlas_delete(atlas_t* atlas)
 {
+    for (size_t i = 0; i < atlas->count; ++i) free(atlas->nodes[i]);
+
     free(atlas->buffer);
-    free(atlas->hashes);
     free(atlas->nodes);
+    free(atlas->spaces);
+    free(atlas->page);
 
     atlas->buffer = NULL;
-    atlas->hashes = NULL;
     atlas->nodes  = NULL;
+    atlas->spaces = NULL;
+    atlas->page   = NULL;
 
     free(atlas);
 }
 
-int (*atlas_add_texture(atlas_t* atlas, uint8_t* pixels, int width, int height))[4]
+atlas_sprite_t* atlas_add_texture(atlas_t* atlas, uint8_t* pixels, int width, int height)
 {
     size_t* size = &atlas->count;
 
     assert(*size < atlas->capacity);
 
-    size_t* hashes         = atlas->hashes;
-    size_t  hash           = atlas_generate_hash(pixels, width * height * RGBA_CHANNELS);
-    bool    hash_is_unique = atlas_check_hash_unique(hash, hashes, *size);
+    size_t        hash      = atlas_generate_hash(pixels, width * height * RGBA_CHANNELS);
+    atlas_node_t* duplicate = atlas_find_hash(atlas, hash);
 
-    if (hash_is_unique)
+    if (duplicate)
     {
-        atlas_node_t* node = (atlas_node_t*)malloc(sizeof(atlas_node_t));
+        ++duplicate->refs;
+        return &duplicate->sprite;
+    }
 
-        int rect[4] = {
-            0,
-            0,
-            width,
-            height,
-        };
+    atlas_node_t* node = (atlas_node_t*)malloc(sizeof(atlas_node_t));
+
+    assert(node);
+
+    int bounds[4];
+
+    atlas_get_opaque_bounds(pixels, width, height, bounds);
 
-        if (node != NULL)
+    int rect[4] = {
+        0,
+        0,
+        bounds[2],
+        bounds[3],
+    };
+
+    int trim[4] = {
+        bounds[0],
+        bounds[1],
+        width,
+        height,
+    };
+
+    uint8_t* origin = pixels + (bounds[0] + bounds[1] * width) * RGBA_CHANNELS;
+
+    // once packed, textures go straight into a free
+    // region of the page instead of the staging buffer
+    if (atlas->page != NULL)
+    {
+        if (!atlas_place(atlas, rect))
         {
-            memcpy(node->rect, rect, 4 * sizeof(int));
+            free(node);
+            return NULL;
+        }
 
-            node->buffer_index = atlas->buffer_index;
+        atlas_blit(atlas, rect, origin, width);
+    }
+    else
+    {
+        node->buffer_index = atlas->buffer_index;
 
-            atlas->hashes[*size]    = hash;
-            atlas->nodes[(*size)++] = node;
+        uint32_t row_length = (uint32_t)(bounds[2] * RGBA_CHANNELS);
 
-            uint32_t buffer_length = (uint32_t)(width * height * RGBA_CHANNELS);
-            memcpy(atlas->buffer + atlas->buffer_index, pixels, buffer_length);
-            atlas->buffer_index += buffer_length;
+        // only the opaque bounds are kept, the
+        // transparent margins never reach the atlas
+        for (int y = 0; y < bounds[3]; ++y)
+        {
+            memcpy(atlas->buffer + atlas->buffer_index, origin + y * width * RGBA_CHANNELS, row_length);
+            atlas->buffer_index += row_length;
         }
+    }
+
+    memcpy(node->sprite.rect, rect, 4 * sizeof(int));
+    memcpy(node->sprite.trim, trim, 4 * sizeof(int));
+
+    atlas_generate_hull(&node->sprite, pixels, width);
+
+    node->hash = hash;
+    node->refs = 1;
+
+    atlas->nodes[(*size)++] = node;
+
+    return &node->sprite;
+}
+
+void atlas_remove_texture(atlas_t* atlas, atlas_sprite_t* sprite)
+{
+    assert(atlas->page != NULL);
+
+    for (size_t i = 0; i < atlas->count; ++i)
+    {
+        atlas_node_t* node = atlas->nodes[i];
+
+        if (&node->sprite != sprite) continue;
+
+        if (--node->refs > 0) return;
 
-        return &node->rect;
+        int padding = atlas->expand * 2 + atlas->border;
+
+        // the old pixels stay on the page, nothing
+        // samples them until the region is reused
+        int space[4] = {
+            sprite->rect[0] - atlas->expand,
+            sprite->rect[1] - atlas->expand,
+            sprite->rect[2] + padding,
+            sprite->rect[3] + padding,
+        };
+
+        atlas_free_space(atlas, space);
+
+        atlas->nodes[i] = atlas->nodes[--atlas->count];
+
+        free(node);
+        return;
     }
 
-    return NULL;
+    assert(false);
+}
+
+bool atlas_replace_texture(atlas_t* atlas, atlas_sprite_t** replaced, uint8_t* pixels, int width, int height)
+{
+    assert(atlas->page != NULL);
+
+    // sprites are the first member of their node
+    atlas_node_t*   node   = (atlas_node_t*)*replaced;
+    atlas_sprite_t* sprite = *replaced;
+
+    // the other textures keep the old pixels,
+    // so this one is added again on its own
+    if (node->refs > 1)
+    {
+        atlas_sprite_t* detached = atlas_add_texture(atlas, pixels, width, height);
+
+        if (!detached) return false;
+
+        --node->refs;
+
+        *replaced = detached;
+
+        return true;
+    }
+
+    int bounds[4];
+
+    atlas_get_opaque_bounds(pixels, width, height, bounds);
+
+    int rect[4] = {
+        sprite->rect[0],
+        sprite->rect[1],
+        bounds[2],
+        bounds[3],
+    };
+
+    // a new size needs a new region, the old one is only
+    // handed back once the texture found somewhere to go
+    if (bounds[2] != sprite->rect[2] || bounds[3] != sprite->rect[3])
+    {
+        if (!atlas_place(atlas, rect)) return false;
+
+        int padding = atlas->expand * 2 + atlas->border;
+
+        int space[4] = {
+            sprite->rect[0] - atlas->expand,
+            sprite->rect[1] - atlas->expand,
+            sprite->rect[2] + padding,
+            sprite->rect[3] + padding,
+        };
+
+        atlas_free_space(atlas, space);
+    }
+
+    int trim[4] = {
+        bounds[0],
+        bounds[1],
+        width,
+        height,
+    };
+
+    memcpy(sprite->rect, rect, 4 * sizeof(int));
+    memcpy(sprite->trim, trim, 4 * sizeof(int));
+
+    atlas_generate_hull(sprite, pixels, width);
+    atlas_blit(atlas, rect, pixels + (bounds[0] + bounds[1] * width) * RGBA_CHANNELS, width);
+
+    node->hash = atlas_generate_hash(pixels, width * height * RGBA_CHANNELS);
+
+    return true;
 }
 
 void atlas_pack(atlas_t* atlas)
 {
     assert(atlas->count > 1);
+    assert(atlas->page == NULL);
 
-    int area    = 0;
-    int max_w   = atlas->nodes[0]->rect[2];
-    int max_h   = atlas->nodes[0]->rect[3];
-    int padding = atlas->expand * 2 + atlas->border;
+    TRACE_BEGIN("atlas_pack");
+
+    int area  = 0;
+    int max_w = atlas->nodes[0]->sprite.rect[2];
+    int max_h = atlas->nodes[0]->sprite.rect[3];
 
     for (int i = 0; i < atlas->count; ++i)
     {
-        while (max_w < atlas->nodes[i]->rect[2])
+        while (max_w < atlas->nodes[i]->sprite.rect[2])
         {
             max_w *= 2;
             max_h = max_w;
@@ -172,175 +785,83 @@ void atlas_pack(atlas_t* atlas)
 
     const size_t len = atlas->count;
 
-    int(*spaces)[4] = malloc(atlas->resolution * 4 * sizeof(int));
-
-    int start_space[4] = {
-        0,
-        0,
-        atlas->resolution,
-        atlas->resolution,
-    };
-
-    memcpy(spaces[0], start_space, 4 * sizeof(int));
-
     qsort(atlas->nodes, len, sizeof(atlas_node_t*), atlas_compare_area);
 
-    int n = 1;
-
     for (int i = 0; i < len; ++i)
     {
-        atlas_node_t* node = atlas->nodes[i];
-
-        int rect[4];
-
-        memcpy(rect, node->rect, 4 * sizeof(int));
+        int* rect = atlas->nodes[i]->sprite.rect;
 
         assert(rect[2] <= atlas->resolution && rect[3] <= atlas->resolution);
 
-        for (int j = n - 1; j >= 0; j--)
-        {
-            int space[4];
+        bool placed = atlas_place(atlas, rect);
 
-            memcpy(space, spaces[j], 4 * sizeof(int));
+        assert(placed);
 
-            int w = rect[2] + padding;
-            int h = rect[3] + padding;
+        while (max_w < rect[0] + rect[2])
+        {
+            max_w *= 2;
+        }
 
-            // check if image too large for space
-            if (w > space[2] || h > space[3]) continue;
+        while (max_h < rect[1] + rect[3])
+        {
+            max_h *= 2;
+        }
+    }
 
-            // add image to space's top-left
-            // |-------|-------|
-            // |  box  |       |
-            // |_______|       |
-            // |         space |
-            // |_______________|
+    atlas->width  = max_w;
+    atlas->height = max_h;
 
-            rect[0] = space[0] + atlas->expand;
-            rect[1] = space[1] + atlas->expand;
+    // whatever lies outside the packed page can't
+    // be used by textures added after generation
+    atlas_clip_spaces(atlas);
 
-            while (max_w < rect[0] + rect[2])
-            {
-                max_w *= 2;
-            }
+    TRACE_END();
+}
 
-            while (max_h < rect[1] + rect[3])
-            {
-                max_h *= 2;
-            }
+void atlas_generate_texture(atlas_t* atlas, uint8_t** pixels, int* width, int* height)
+{
+    TRACE_BEGIN("atlas_generate_texture");
 
-            if (w == space[2] && h == space[3])
-            {
-                // remove space if perfect fit
-                // |---------------|
-                // |               |
-                // |      box      |
-                // |               |
-                // |_______________|
+    size_t size = atlas->width * atlas->height * RGBA_CHANNELS * sizeof(uint8_t);
 
-                int last[4];
+    atlas->page = (uint8_t*)malloc(size);
 
-                memcpy(last, spaces[--n], 4 * sizeof(int));
+    assert(atlas->page);
 
-                if (j < n) memcpy(spaces[j], last, 4 * sizeof(int));
-            }
-            else if (h == space[3])
-            {
-                // space matches image height
-                // move space right and cut off width
-                // |-------|---------------|
-                // |  box  | updated space |
-                // |_______|_______________|
-
-                spaces[j][0] += w;
-                spaces[j][2] -= w;
-            }
-            else if (w == space[2])
-            {
-                // space matches image width
-                // move space down and cut off height
-                // |---------------|
-                // |      box      |
-                // |_______________|
-                // | updated space |
-                // |_______________|
-
-                spaces[j][1] += h;
-                spaces[j][3] -= h;
-            }
-            else
-            {
-                // split width and height
-                // difference into two new spaces
-                // |-------|-----------|
-                // |  box  | new space |
-                // |_______|___________|
-                // | updated space     |
-                // |___________________|
-
-                int new_space[4] = {
-                    space[0] + w,
-                    space[1],
-                    space[2] - w,
-                    h,
-                };
-
-                memcpy(spaces[n++], new_space, 4 * sizeof(int));
-
-                spaces[j][1] += h;
-                spaces[j][3] -= h;
-            }
+    memset(atlas->page, 0, size);
 
-            break;
-        }
+    for (int i = 0; i < atlas->count; ++i)
+    {
+        const atlas_node_t* node = atlas->nodes[i];
 
-        memcpy(node->rect, rect, 4 * sizeof(int));
+        atlas_blit(atlas, node->sprite.rect, atlas->buffer + node->buffer_index, node->sprite.rect[2]);
     }
 
-    atlas->width  = max_w;
-    atlas->height = max_h;
-}
+    // the staging buffer isn't needed once
+    // every texture is copied into the page
+    free(atlas->buffer);
 
-void atlas_generate_texture(atlas_t* atlas, uint8_t** pixels, int* width, int* height)
-{
-    size_t size = atlas->width * atlas->height * RGBA_CHANNELS * sizeof(uint8_t);
+    atlas->buffer = NULL;
 
-    *pixels = (uint8_t*)malloc(size);
+    memset(atlas->dirty, 0, 4 * sizeof(int));
 
+    *pixels = atlas->page;
     *width  = atlas->width;
     *height = atlas->height;
 
-    memset(*pixels, 0, size);
-
-    for (int i = 0; i < atlas->count; ++i)
-    {
-        const atlas_node_t* node = atlas->nodes[i];
+    TRACE_END();
+}
 
-        const int rect[4] = {
-            node->rect[0],
-            node->rect[1],
-            node->rect[2],
-            node->rect[3],
-        };
+bool atlas_flush(atlas_t* atlas, int dirty[4])
+{
+    if (atlas->dirty[2] == 0 || atlas->dirty[3] == 0) return false;
 
-        uint8_t* src_buffer = atlas->buffer + node->buffer_index;
-        uint8_t* dst_buffer = *pixels;
+    memcpy(dirty, atlas->dirty, 4 * sizeof(int));
 
-        for (int y = -atlas->expand * RGBA_CHANNELS; y < (int)(rect[3] + atlas->expand) * RGBA_CHANNELS; y += RGBA_CHANNELS)
-        {
-            for (int x = -atlas->expand * RGBA_CHANNELS; x < (int)(rect[2] + atlas->expand) * RGBA_CHANNELS; x += RGBA_CHANNELS)
-            {
-                int src_x = x < 0 ? 0 : x > (rect[2] - 1) * RGBA_CHANNELS ? (rect[2] - 1) * RGBA_CHANNELS : x;
-                int src_y = y < 0 ? 0 : y > (rect[3] - 1) * RGBA_CHANNELS ? (rect[3] - 1) * RGBA_CHANNELS : y;
+    if (dirty[0] + dirty[2] > atlas->width) dirty[2] = atlas->width - dirty[0];
+    if (dirty[1] + dirty[3] > atlas->height) dirty[3] = atlas->height - dirty[1];
 
-                int dst_pixel_index = rect[0] * RGBA_CHANNELS + x + (rect[1] * RGBA_CHANNELS + y) * atlas->width;
-                int src_pixel_index = src_x + src_y * rect[2];
+    memset(atlas->dirty, 0, 4 * sizeof(int));
 
-                dst_buffer[dst_pixel_index + 0] = src_buffer[src_pixel_index + 0];
-                dst_buffer[dst_pixel_index + 1] = src_buffer[src_pixel_index + 1];
-                dst_buffer[dst_pixel_index + 2] = src_buffer[src_pixel_index + 2];
-                dst_buffer[dst_pixel_index + 3] = src_buffer[src_pixel_index + 3];
-            }
-        }
-    }
+    return true;
 }
@@ -11,9 +11,12 @@
 #ifndef GRAPHICS_ATLAS_H
 #define GRAPHICS_ATLAS_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+#define ATLAS_HULL_MAX_VERTICES (8)
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -30,14 +33,35 @@ extern "C"
         uint16_t resolution;
     } atlas_desc_t;
 
+    typedef struct atlas_sprite_t
+    {
+        int rect[4];  // packed region inside the atlas
+        int trim[4];  // offset of the region and size of the untrimmed image
+
+        uint8_t hull_len;                          // zero when drawn as a plain quad
+        float   hull[ATLAS_HULL_MAX_VERTICES][2];  // convex outline relative to rect
+    } atlas_sprite_t;
+
     atlas_t* atlas_new(atlas_desc_t desc);
     void     atlas_delete(atlas_t* atlas);
 
-    int (*atlas_add_texture(atlas_t* atlas, uint8_t* pixels, int width, int height))[4];
+    // after generation textures are placed right away and NULL
+    // is returned only when no free region fits, identical
+    // pixels get the existing sprite, removed once per add
+    atlas_sprite_t* atlas_add_texture(atlas_t* atlas, uint8_t* pixels, int width, int height);
+    void            atlas_remove_texture(atlas_t* atlas, atlas_sprite_t* sprite);
+
+    // a shared sprite is left to the others, the replaced
+    // texture is moved to a sprite of its own in its place
+    bool atlas_replace_texture(atlas_t* atlas, atlas_sprite_t** replaced, uint8_t* pixels, int width, int height);
 
     void atlas_pack(atlas_t* atlas);
     void atlas_generate_texture(atlas_t* atlas, uint8_t** pixels, int* width, int* height);
 
+    // pixels returned by generation stay owned by the atlas,
+    // flush reports the region changed since the last call
+    bool atlas_flush(atlas_t* atlas, int dirty[4]);
+
 #ifdef __cplusplus
 }
 #endif
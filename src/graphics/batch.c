@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "graphics/atlas.h"
 #include "graphics/batch.h"
 #include "graphics/color.h"
 #include "graphics/renderer.h"
@@ -224,6 +225,8 @@ void batch_set_shader(uint32_t id)
         batch_flush();
     }
 
+    shader_id = id;
+
     renderer_shader_bind(id);
 }
 
@@ -395,6 +398,84 @@ static void draw_quad(quad_desc_t src, quad_desc_t dst)
     vertices_len += VERTEX_PER_QUAD;
 }
 
+static vertex_t* push_mesh(vertex_t* buffer, const atlas_sprite_t* sprite, float dst[4])
+{
+    const int* rect = sprite->rect;
+    const int* trim = sprite->trim;
+
+    float scale_x = dst[2] / trim[2];
+    float scale_y = dst[3] / trim[3];
+
+    float sin = sinf(rotation);
+    float cos = cosf(rotation);
+
+    float rgb0[3];
+    float rgb1[3];
+
+    rgb_from_hex(tint, rgb0);
+    rgb_from_hex(fill, rgb1);
+
+    for (int i = 0; i < sprite->hull_len; ++i)
+    {
+        float hx = sprite->hull[i][0];
+        float hy = sprite->hull[i][1];
+
+        float px = trim[0] + hx;
+        float py = trim[1] + hy;
+
+        if ((flip & BATCH_FLIP_HORZ) == BATCH_FLIP_HORZ) px = trim[2] - px;
+        if ((flip & BATCH_FLIP_VERT) == BATCH_FLIP_VERT) py = trim[3] - py;
+
+        float dx = dst[0] + px * scale_x - origin[0];
+        float dy = dst[1] + py * scale_y - origin[1];
+
+        buffer->x  = dx * cos - dy * sin + origin[0];
+        buffer->y  = dx * sin + dy * cos + origin[1];
+        buffer->z  = 0;
+        buffer->u  = (rect[0] + hx) / texture_width;
+        buffer->v  = (rect[1] + hy) / texture_height;
+        buffer->r0 = rgb0[0];
+        buffer->g0 = rgb0[1];
+        buffer->b0 = rgb0[2];
+        buffer->a0 = tint_alpha;
+        buffer->r1 = rgb1[0];
+        buffer->g1 = rgb1[1];
+        buffer->b1 = rgb1[2];
+        buffer->a1 = fill_alpha;
+        buffer++;
+    }
+
+    return buffer;
+}
+
+static void draw_mesh(const atlas_sprite_t* sprite, float dst[4])
+{
+    assert(began);
+
+    size_t mesh_vertices_len = sprite->hull_len;
+    size_t mesh_indices_len  = (sprite->hull_len - 2) * INDEX_PER_TRIANGLE;
+
+    if (vertices_len + mesh_vertices_len > quads_capacity * VERTEX_PER_QUAD || indices_len + mesh_indices_len > quads_capacity * INDEX_PER_QUAD)
+    {
+        batch_flush();
+    }
+
+    // hulls are counter-clockwise, so the fan is emitted
+    // reversed to match the quads unless a flip mirrored it
+    bool mirrored = flip == BATCH_FLIP_HORZ || flip == BATCH_FLIP_VERT;
+
+    for (size_t i = 1; i + 1 < mesh_vertices_len; ++i)
+    {
+        indices[indices_len + 0] = 0 + vertices_len;
+        indices[indices_len + 1] = (mirrored ? i : i + 1) + vertices_len;
+        indices[indices_len + 2] = (mirrored ? i + 1 : i) + vertices_len;
+        indices_len += INDEX_PER_TRIANGLE;
+    }
+
+    vertices_write = push_mesh(vertices_write, sprite, dst);
+    vertices_len += mesh_vertices_len;
+}
+
 void batch_draw_texture(float src[4], float dst[4])
 {
     quad_desc_t src_rect = {
@@ -421,3 +502,37 @@ void batch_draw_texture(float src[4], float dst[4])
 
     draw_quad(src_rect, dst_rect);
 }
+
+void batch_draw_sprite(const atlas_sprite_t* sprite, float dst[4])
+{
+    if (sprite->hull_len > 0)
+    {
+        draw_mesh(sprite, dst);
+        return;
+    }
+
+    const int* rect = sprite->rect;
+    const int* trim = sprite->trim;
+
+    float scale_x = dst[2] / trim[2];
+    float scale_y = dst[3] / trim[3];
+
+    // trimmed margins are mirrored along with the uvs
+    float offset_x = (flip & BATCH_FLIP_HORZ) == BATCH_FLIP_HORZ ? trim[2] - trim[0] - rect[2] : trim[0];
+    float offset_y = (flip & BATCH_FLIP_VERT) == BATCH_FLIP_VERT ? trim[3] - trim[1] - rect[3] : trim[1];
+
+    batch_draw_texture(
+        (float[4]){
+            rect[0],
+            rect[1],
+            rect[2],
+            rect[3],
+        },
+        (float[4]){
+            dst[0] + offset_x * scale_x,
+            dst[1] + offset_y * scale_y,
+            rect[2] * scale_x,
+            rect[3] * scale_y,
+        }
+    );
+}
@@ -20,6 +20,8 @@ extern "C"
 {
 #endif
 
+    typedef struct atlas_sprite_t atlas_sprite_t;
+
     enum
     {
         BATCH_FLIP_NONE = 0x0,
@@ -44,6 +46,7 @@ extern "C"
     void batch_set_texture(uint32_t id, int width, int height);
 
     void batch_draw_texture(float src[4], float dst[4]);
+    void batch_draw_sprite(const atlas_sprite_t* sprite, float dst[4]);
 
 #ifdef __cplusplus
 }
@@ -22,12 +22,15 @@
 
 #include "graphics/renderer.h"
 
+#include "platform/trace.h"
+
 typedef void          GLvoid;
 typedef ptrdiff_t     GLintptr;
 typedef ptrdiff_t     GLsizeiptr;
 typedef unsigned int  GLenum;
 typedef unsigned int  GLbitfield;
 typedef unsigned char GLboolean;
+typedef unsigned char GLubyte;
 typedef char          GLchar;
 typedef int           GLint;
 typedef unsigned int  GLuint;
@@ -49,6 +52,15 @@ typedef double        GLdouble;
 #define GL_LINK_STATUS                   0x8B82
 #define GL_VALIDATE_STATUS               0x8B83
 #define GL_INFO_LOG_LENGTH               0x8B84
+#define GL_ACTIVE_UNIFORMS               0x8B86
+#define GL_SHADER_TYPE                   0x8B4F
+#define GL_EXTENSIONS                    0x1F03
+#define GL_NUM_EXTENSIONS                0x821D
+#define GL_FLOAT_VEC2                    0x8B50
+#define GL_FLOAT_VEC3                    0x8B51
+#define GL_FLOAT_VEC4                    0x8B52
+#define GL_FLOAT_MAT4                    0x8B5C
+#define GL_SAMPLER_2D                    0x8B5E
 #define GL_COLOR_BUFFER_BIT              0x4000
 #define GL_TEXTURE0                      0x84C0
 #define GL_TEXTURE_2D                    0x0DE1
@@ -60,6 +72,7 @@ typedef double        GLdouble;
 #define GL_LINEAR                        0x2601
 #define GL_RGBA                          0x1908
 #define GL_RGBA16F                       0x881A
+#define GL_UNPACK_ROW_LENGTH             0x0CF2
 #define GL_REPEAT                        0x2901
 #define GL_CLAMP_TO_EDGE                 0x812F
 #define GL_CLAMP_TO_BORDER               0x812D
@@ -101,6 +114,7 @@ typedef double        GLdouble;
 #define GL_STACK_UNDERFLOW               0x0504
 #define GL_OUT_OF_MEMORY                 0x0505
 #define GL_INVALID_FRAMEBUFFER_OPERATION 0x0506
+#define GL_COMPLETION_STATUS_KHR         0x91B1
 
 typedef void* (*GLLoadFunc)(const char* name);
 typedef const GLenum (*GLGETERRORPROC)(void);
@@ -127,6 +141,8 @@ typedef void (*GLVERTEXATTRIBIPOINTERPROC)(GLuint index, GLint size, GLenum type
 typedef void (*GLVERTEXATTRIBDIVISORPROC)(GLuint index, GLuint divisor);
 typedef void (*GLGENTEXTURESPROC)(GLint n, void* textures);
 typedef void (*GLTEXIMAGE2DPROC)(GLenum target, GLint level, GLenum internalFormat, GLint width, GLint height, GLint border, GLenum format, GLenum type, const void* pixels);
+typedef void (*GLTEXSUBIMAGE2DPROC)(GLenum target, GLint level, GLint x, GLint y, GLint width, GLint height, GLenum format, GLenum type, const void* pixels);
+typedef void (*GLPIXELSTOREIPROC)(GLenum name, GLint param);
 typedef void (*GLTEXPARAMETERIPROC)(GLenum target, GLenum name, GLint param);
 typedef void (*GLTEXPARAMETERFVPROC)(GLenum target, GLenum name, GLfloat* param);
 typedef void (*GLACTIVETEXTUREPROC)(GLuint id);
@@ -142,9 +158,15 @@ typedef GLuint (*GLCREATEPROGRAMPROC)(void);
 typedef void (*GLDELETEPROGRAMPROC)(GLuint program);
 typedef void (*GLLINKPROGRAMPROC)(GLuint program);
 typedef void (*GLVALIDATEPROGRAMPROC)(GLuint pipeline);
+typedef void (*GLGETATTACHEDSHADERSPROC)(GLuint program, GLsizei maxCount, GLsizei* count, GLuint* shaders);
+typedef void (*GLDETACHSHADERPROC)(GLuint program, GLuint shader);
+typedef void (*GLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+typedef void (*GLGETINTEGERVPROC)(GLenum name, GLint* data);
+typedef const GLubyte* (*GLGETSTRINGIPROC)(GLenum name, GLuint index);
 typedef void (*GLUSEPROGRAMPROC)(GLuint program);
 typedef void (*GLGETPROGRAMIVPROC)(GLuint program, GLenum pname, GLint* params);
 typedef GLint (*GLGETUNIFORMLOCATIONPROC)(GLuint program, const GLchar* name);
+typedef void (*GLGETACTIVEUNIFORMPROC)(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name);
 typedef void (*GLUNIFORM1IPROC)(GLint location, GLint v0);
 typedef void (*GLUNIFORM1FPROC)(GLint location, GLfloat v0);
 typedef void (*GLUNIFORM2FPROC)(GLint location, GLfloat v0, GLfloat v1);
@@ -189,6 +211,8 @@ GLVERTEXATTRIBIPOINTERPROC    gl_glVertexAttribIPointer;
 GLVERTEXATTRIBDIVISORPROC     gl_glVertexAttribDivisor;
 GLGENTEXTURESPROC             gl_glGenTextures;
 GLTEXIMAGE2DPROC              gl_glTexImage2D;
+GLTEXSUBIMAGE2DPROC           gl_glTexSubImage2D;
+GLPIXELSTOREIPROC             gl_glPixelStorei;
 GLTEXPARAMETERIPROC           gl_glTexParameteri;
 GLTEXPARAMETERFVPROC          gl_glTexParameterfv;
 GLACTIVETEXTUREPROC           gl_glActiveTexture;
@@ -204,9 +228,16 @@ GLCREATEPROGRAMPROC           gl_glCreateProgram;
 GLDELETEPROGRAMPROC           gl_glDeleteProgram;
 GLLINKPROGRAMPROC             gl_glLinkProgram;
 GLVALIDATEPROGRAMPROC         gl_glValidateProgram;
+GLGETATTACHEDSHADERSPROC      gl_glGetAttachedShaders;
+GLDETACHSHADERPROC            gl_glDetachShader;
+GLGETINTEGERVPROC             gl_glGetIntegerv;
+GLGETSTRINGIPROC              gl_glGetStringi;
+
+GLMAXSHADERCOMPILERTHREADSKHRPROC gl_glMaxShaderCompilerThreadsKHR;
 GLUSEPROGRAMPROC              gl_glUseProgram;
 GLGETPROGRAMIVPROC            gl_glGetProgramiv;
 GLGETUNIFORMLOCATIONPROC      gl_glGetUniformLocation;
+GLGETACTIVEUNIFORMPROC        gl_glGetActiveUniform;
 GLUNIFORM1IPROC               gl_glUniform1i;
 GLUNIFORM1FPROC               gl_glUniform1f;
 GLUNIFORM2FPROC               gl_glUniform2f;
@@ -266,6 +297,8 @@ GLBLITFRAMEBUFFERPROC         gl_glBlitFramebuffer;
 #define glCreateShader(...)            GL_CALL_RETURN(gl_glCreateShader(__VA_ARGS__))
 #define glGenTextures(...)             GL_CALL(gl_glGenTextures(__VA_ARGS__))
 #define glTexImage2D(...)              GL_CALL(gl_glTexImage2D(__VA_ARGS__))
+#define glTexSubImage2D(...)           GL_CALL(gl_glTexSubImage2D(__VA_ARGS__))
+#define glPixelStorei(...)             GL_CALL(gl_glPixelStorei(__VA_ARGS__))
 #define glTexParameteri(...)           GL_CALL(gl_glTexParameteri(__VA_ARGS__))
 #define glTexParameterfv(...)          GL_CALL(gl_glTexParameterfv(__VA_ARGS__))
 #define glActiveTexture(...)           GL_CALL(gl_glActiveTexture(__VA_ARGS__))
@@ -280,9 +313,14 @@ GLBLITFRAMEBUFFERPROC         gl_glBlitFramebuffer;
 #define glDeleteProgram(...)           GL_CALL(gl_glDeleteProgram(__VA_ARGS__))
 #define glLinkProgram(...)             GL_CALL(gl_glLinkProgram(__VA_ARGS__))
 #define glValidateProgram(...)         GL_CALL(gl_glValidateProgram(__VA_ARGS__))
+#define glGetAttachedShaders(...)      GL_CALL(gl_glGetAttachedShaders(__VA_ARGS__))
+#define glDetachShader(...)            GL_CALL(gl_glDetachShader(__VA_ARGS__))
+#define glGetIntegerv(...)             GL_CALL(gl_glGetIntegerv(__VA_ARGS__))
+#define glGetStringi(...)              GL_CALL_RETURN(gl_glGetStringi(__VA_ARGS__))
 #define glUseProgram(...)              GL_CALL(gl_glUseProgram(__VA_ARGS__))
 #define glGetProgramiv(...)            GL_CALL(gl_glGetProgramiv(__VA_ARGS__))
 #define glGetUniformLocation(...)      GL_CALL_RETURN(gl_glGetUniformLocation(__VA_ARGS__))
+#define glGetActiveUniform(...)        GL_CALL(gl_glGetActiveUniform(__VA_ARGS__))
 #define glUniform1i(...)               GL_CALL(gl_glUniform1i(__VA_ARGS__))
 #define glUniform1f(...)               GL_CALL(gl_glUniform1f(__VA_ARGS__))
 #define glUniform2f(...)               GL_CALL(gl_glUniform2f(__VA_ARGS__))
@@ -332,6 +370,24 @@ static bool errors_check(const char* fn, uint32_t line)
     return true;
 }
 
+static bool renderer_parallel_compile;
+
+static bool renderer_has_extension(const char* name)
+{
+    GLint len = 0;
+
+    glGetIntegerv(GL_NUM_EXTENSIONS, &len);
+
+    for (GLint i = 0; i < len; ++i)
+    {
+        const GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);
+
+        if (extension && strcmp((const char*)extension, name) == 0) return true;
+    }
+
+    return false;
+}
+
 void renderer_bind(void* (*fn)(const char*))
 {
     gl_glGetError                = (GLGETERRORPROC)fn("glGetError");
@@ -358,6 +414,8 @@ void renderer_bind(void* (*fn)(const char*))
     gl_glVertexAttribDivisor     = (GLVERTEXATTRIBDIVISORPROC)fn("glVertexAttribDivisor");
     gl_glGenTextures             = (GLGENTEXTURESPROC)fn("glGenTextures");
     gl_glTexImage2D              = (GLTEXIMAGE2DPROC)fn("glTexImage2D");
+    gl_glTexSubImage2D           = (GLTEXSUBIMAGE2DPROC)fn("glTexSubImage2D");
+    gl_glPixelStorei             = (GLPIXELSTOREIPROC)fn("glPixelStorei");
     gl_glTexParameteri           = (GLTEXPARAMETERIPROC)fn("glTexParameteri");
     gl_glTexParameterfv          = (GLTEXPARAMETERFVPROC)fn("glTexParameterfv");
     gl_glActiveTexture           = (GLACTIVETEXTUREPROC)fn("glActiveTexture");
@@ -373,9 +431,14 @@ void renderer_bind(void* (*fn)(const char*))
     gl_glDeleteProgram           = (GLDELETEPROGRAMPROC)fn("glDeleteProgram");
     gl_glLinkProgram             = (GLLINKPROGRAMPROC)fn("glLinkProgram");
     gl_glValidateProgram         = (GLVALIDATEPROGRAMPROC)fn("glValidateProgram");
+    gl_glGetAttachedShaders      = (GLGETATTACHEDSHADERSPROC)fn("glGetAttachedShaders");
+    gl_glDetachShader            = (GLDETACHSHADERPROC)fn("glDetachShader");
+    gl_glGetIntegerv             = (GLGETINTEGERVPROC)fn("glGetIntegerv");
+    gl_glGetStringi              = (GLGETSTRINGIPROC)fn("glGetStringi");
     gl_glUseProgram              = (GLUSEPROGRAMPROC)fn("glUseProgram");
     gl_glGetProgramiv            = (GLGETPROGRAMIVPROC)fn("glGetProgramiv");
     gl_glGetUniformLocation      = (GLGETUNIFORMLOCATIONPROC)fn("glGetUniformLocation");
+    gl_glGetActiveUniform        = (GLGETACTIVEUNIFORMPROC)fn("glGetActiveUniform");
     gl_glUniform1i               = (GLUNIFORM1IPROC)fn("glUniform1i");
     gl_glUniform1f               = (GLUNIFORM1FPROC)fn("glUniform1f");
     gl_glUniform2f               = (GLUNIFORM2FPROC)fn("glUniform2f");
@@ -395,6 +458,17 @@ void renderer_bind(void* (*fn)(const char*))
     gl_glReadBuffer              = (GLREADBUFFERPROC)fn("glReadBuffer");
     gl_glDrawBuffers             = (GLDRAWBUFFERSPROC)fn("glDrawBuffers");
     gl_glBlitFramebuffer         = (GLBLITFRAMEBUFFERPROC)fn("glBlitFramebuffer");
+
+    gl_glMaxShaderCompilerThreadsKHR = (GLMAXSHADERCOMPILERTHREADSKHRPROC)fn("glMaxShaderCompilerThreadsKHR");
+
+    // with the extension the driver compiles submitted
+    // programs on its own threads, as many as it likes
+    if (gl_glMaxShaderCompilerThreadsKHR && renderer_has_extension("GL_KHR_parallel_shader_compile"))
+    {
+        gl_glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+
+        renderer_parallel_compile = true;
+    }
 }
 
 void renderer_viewport(int x, int y, int width, int height) { glViewport(x, y, width, height); }
@@ -560,6 +634,8 @@ uint32_t renderer_texture_generate(const void* pixels, int width, int height, TE
 {
     uint32_t id;
 
+    TRACE_BEGIN("renderer_texture_generate");
+
     glGenTextures(1, &id);
     glBindTexture(GL_TEXTURE_2D, id);
 
@@ -574,9 +650,32 @@ uint32_t renderer_texture_generate(const void* pixels, int width, int height, TE
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
+    TRACE_END();
+
     return id;
 }
 
+void renderer_texture_subdata(uint32_t id, const void* pixels, int stride, const int rect[4], TEXTURE_FORMAT format)
+{
+    glBindTexture(GL_TEXTURE_2D, id);
+
+    // pixels point at the whole image, the row
+    // length lets gl skip to the updated region
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+
+    switch (format)
+    {
+        case TEXTURE_FORMAT_FLOAT:
+            glTexSubImage2D(GL_TEXTURE_2D, 0, rect[0], rect[1], rect[2], rect[3], GL_RGBA, GL_FLOAT, (const float*)pixels + (rect[0] + rect[1] * stride) * 4);
+            break;
+        case TEXTURE_FORMAT_UBYTE:
+            glTexSubImage2D(GL_TEXTURE_2D, 0, rect[0], rect[1], rect[2], rect[3], GL_RGBA, GL_UNSIGNED_BYTE, (const uint8_t*)pixels + (rect[0] + rect[1] * stride) * 4);
+            break;
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
 static uint32_t shader_compile_source(uint32_t type, const char* source)
 {
     uint32_t shader = glCreateShader(type);
@@ -584,16 +683,23 @@ static uint32_t shader_compile_source(uint32_t type, const char* source)
     glShaderSource(shader, 1, &source, NULL);
     glCompileShader(shader);
 
+    return shader;
+}
+
+static bool shader_check_compiled(uint32_t shader)
+{
     GLint compiled;
 
     glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
 
-#ifdef DEBUG
     if (compiled == GL_FALSE)
     {
-        GLint len = 0;
+#ifdef DEBUG
+        GLint len  = 0;
+        GLint type = 0;
 
         glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &len);
+        glGetShaderiv(shader, GL_SHADER_TYPE, &type);
 
         char* error = (char*)malloc(len);
 
@@ -601,46 +707,73 @@ static uint32_t shader_compile_source(uint32_t type, const char* source)
 
         printf("[%s] %s", type == GL_VERTEX_SHADER ? "VERTEX SHADER" : "FRAGMENT SHADER", error);
         free(error);
-
-        glDeleteShader(shader);
-    }
 #endif
 
-    assert(compiled == GL_TRUE);
+        return false;
+    }
 
-    return shader;
+    return true;
 }
 
-uint32_t renderer_shader_generate(const char* vertex_shader_source, const char* fragment_shader_source)
+uint32_t renderer_shader_submit(const char* vertex_shader_source, const char* fragment_shader_source)
 {
+    TRACE_BEGIN("renderer_shader_submit");
+
     uint32_t vertex_shader   = shader_compile_source(GL_VERTEX_SHADER, vertex_shader_source);
     uint32_t fragment_shader = shader_compile_source(GL_FRAGMENT_SHADER, fragment_shader_source);
 
-    GLint vertex_compiled;
-    GLint fragment_compiled;
-
-    glGetShaderiv(vertex_shader, GL_COMPILE_STATUS, &vertex_compiled);
-    glGetShaderiv(fragment_shader, GL_COMPILE_STATUS, &fragment_compiled);
-
-    assert(vertex_compiled == GL_TRUE);
-    assert(fragment_compiled == GL_TRUE);
-
     uint32_t program = glCreateProgram();
 
+    // nothing is queried here, the driver is free to
+    // compile and link until the program is finished
     glAttachShader(program, vertex_shader);
     glAttachShader(program, fragment_shader);
     glLinkProgram(program);
-    glValidateProgram(program);
 
-    GLint linked;
-    GLint validated;
+    TRACE_END();
 
-    glGetProgramiv(program, GL_LINK_STATUS, &linked);
-    glGetProgramiv(program, GL_VALIDATE_STATUS, &validated);
+    return program;
+}
 
-#ifdef DEBUG
-    if (linked == GL_FALSE)
+bool renderer_shader_ready(uint32_t program)
+{
+    // without the extension there's nothing to ask,
+    // finish then blocks on the first status query
+    if (!renderer_parallel_compile) return true;
+
+    GLint completed = GL_FALSE;
+
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completed);
+
+    return completed == GL_TRUE;
+}
+
+bool renderer_shader_finish(uint32_t program)
+{
+    TRACE_BEGIN("renderer_shader_finish");
+
+    GLuint  shaders[2];
+    GLsizei shaders_len = 0;
+
+    glGetAttachedShaders(program, 2, &shaders_len, shaders);
+
+    bool compiled = true;
+
+    for (int i = 0; i < shaders_len; ++i)
+    {
+        compiled = shader_check_compiled(shaders[i]) && compiled;
+    }
+
+    GLint linked = GL_FALSE;
+
+    if (compiled)
+    {
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    }
+
+    if (compiled && linked == GL_FALSE)
     {
+#ifdef DEBUG
         GLint len = 0;
 
         glGetProgramiv(program, GL_INFO_LOG_LENGTH, &len);
@@ -651,20 +784,32 @@ uint32_t renderer_shader_generate(const char* vertex_shader_source, const char*
 
         printf("[SHADER PROGRAM] %s", error);
         free(error);
+#endif
+    }
 
+    for (int i = 0; i < shaders_len; ++i)
+    {
+        glDetachShader(program, shaders[i]);
+        glDeleteShader(shaders[i]);
+    }
+
+    // failures return false so a hot reload
+    // can keep the previous program around
+    if (linked == GL_FALSE)
+    {
         glDeleteProgram(program);
-        glDeleteShader(vertex_shader);
-        glDeleteShader(fragment_shader);
     }
-#endif
 
-    assert(linked == GL_TRUE);
-    // assert(validated == GL_TRUE);
+    TRACE_END();
+
+    return linked == GL_TRUE;
+}
 
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
+uint32_t renderer_shader_generate(const char* vertex_shader_source, const char* fragment_shader_source)
+{
+    uint32_t program = renderer_shader_submit(vertex_shader_source, fragment_shader_source);
 
-    return program;
+    return renderer_shader_finish(program) ? program : 0;
 }
 
 uint32_t renderer_frame_buffer_generate(void)
@@ -963,6 +1108,40 @@ void renderer_texture_set_filter(TEXTURE_FILTER filter)
 
 int renderer_shader_get_uniform_location(uint32_t id, const char* name) { return glGetUniformLocation(id, name); }
 
+int renderer_shader_get_uniforms_len(uint32_t id)
+{
+    GLint len = 0;
+
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &len);
+
+    return len;
+}
+
+UNIFORM_TYPE renderer_shader_get_uniform(uint32_t id, int index, char* name, size_t name_size, int* count)
+{
+    GLsizei len  = 0;
+    GLint   size = 0;
+    GLenum  type = GL_NONE;
+
+    glGetActiveUniform(id, index, (GLsizei)name_size, &len, &size, &type, name);
+
+    *count = size;
+
+    switch (type)
+    {
+        case GL_INT:
+        case GL_BOOL:
+        case GL_SAMPLER_2D: return UNIFORM_INT;
+        case GL_FLOAT: return UNIFORM_FLOAT;
+        case GL_FLOAT_VEC2: return UNIFORM_VEC2;
+        case GL_FLOAT_VEC3: return UNIFORM_VEC3;
+        case GL_FLOAT_VEC4: return UNIFORM_VEC4;
+        case GL_FLOAT_MAT4: return UNIFORM_MAT4;
+
+        default: return UNIFORM_OTHER;
+    }
+}
+
 void renderer_shader_set_uniformi(int location, int value) { glUniform1i(location, value); }
 
 void renderer_shader_set_uniformf(int location, float value) { glUniform1f(location, value); }
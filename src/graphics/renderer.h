@@ -11,6 +11,7 @@
 #ifndef GRAPHICS_RENDERER_H
 #define GRAPHICS_RENDERER_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -37,6 +38,17 @@ extern "C"
         ATTRIBUTE_MAT4,
     } ATTRIBUTE_TYPE;
 
+    typedef enum UNIFORM_TYPE
+    {
+        UNIFORM_OTHER,
+        UNIFORM_INT,
+        UNIFORM_FLOAT,
+        UNIFORM_VEC2,
+        UNIFORM_VEC3,
+        UNIFORM_VEC4,
+        UNIFORM_MAT4,
+    } UNIFORM_TYPE;
+
     typedef enum DRAW_MODE
     {
         DRAW_LINES,
@@ -111,6 +123,13 @@ extern "C"
     uint32_t renderer_vertex_array_generate(void);
     uint32_t renderer_texture_generate(const void* pixels, int width, int height, TEXTURE_FORMAT format);
     uint32_t renderer_shader_generate(const char* vertex_shader_source, const char* fragment_shader_source);
+
+    // submitted programs are only checked once finished, in between
+    // the driver may compile them in parallel with other work, ready
+    // says whether finishing would return without waiting on it
+    uint32_t renderer_shader_submit(const char* vertex_shader_source, const char* fragment_shader_source);
+    bool     renderer_shader_ready(uint32_t program);
+    bool     renderer_shader_finish(uint32_t program);
     uint32_t renderer_frame_buffer_generate(void);
     uint32_t renderer_frame_buffer_attachment_generate(int width, int height, ATTACHMENT_TYPE attachment);
 
@@ -144,11 +163,15 @@ extern "C"
     void renderer_vertex_array_add_buffer(uint32_t id, uint32_t vertex_buffer_id, size_t layout_len, ATTRIBUTE_TYPE* layout);
     void renderer_vertex_buffer_subdata(void* data, size_t size);
     void renderer_index_buffer_subdata(void* data, size_t size);
+    void renderer_texture_subdata(uint32_t id, const void* pixels, int stride, const int rect[4], TEXTURE_FORMAT format);
 
     void renderer_texture_set_wrap(TEXTURE_WRAP wrap);
     void renderer_texture_set_filter(TEXTURE_FILTER filter);
 
-    int  renderer_shader_get_uniform_location(uint32_t id, const char* name);
+    int          renderer_shader_get_uniform_location(uint32_t id, const char* name);
+    int          renderer_shader_get_uniforms_len(uint32_t id);
+    UNIFORM_TYPE renderer_shader_get_uniform(uint32_t id, int index, char* name, size_t name_size, int* count);
+
     void renderer_shader_set_uniformi(int location, int value);
     void renderer_shader_set_uniformf(int location, float value);
     void renderer_shader_set_uniform2f(int location, float* value);
@@ -17,161 +17,534 @@
 #include "graphics/shader.h"
 #include "graphics/renderer.h"
 
-#define SHADER_MAX_LINE_LENGTH (4096)
-#define SHADER_MAX_LINE_COUNT  (8192)
+#include "platform/filesystem.h"
 
-#define VERTEX_SHADER_TAG      ("@vs")
-#define FRAGMENT_SHADER_TAG    ("@fs")
+#define VERTEX_SHADER_TAG   ("@vs")
+#define FRAGMENT_SHADER_TAG ("@fs")
+#define VARIANT_TAG         ("@variant")
+#define INCLUDE_DIRECTIVE   ("#include")
 
-static void prepend_precision(char* shader)
+typedef struct shader_buffer_t
 {
-#ifdef __EMSCRIPTEN__
-    strcat(shader, "precision mediump float;");
-    strcat(shader, "\n");
-#endif
+    char*  data;
+    size_t len;
+    size_t capacity;
+} shader_buffer_t;
+
+typedef struct shader_builder_t
+{
+    shader_buffer_t  vs;
+    shader_buffer_t  fs;
+    shader_buffer_t* stage;
+    shader_desc_t    desc;
+    bool             failed;
+} shader_builder_t;
+
+static shader_stats_t shader_stats;
+
+static void shader_preprocess(shader_builder_t* builder, const char* source, size_t size, int depth);
+
+static void shader_buffer_append(shader_buffer_t* buffer, const char* str, size_t len)
+{
+    if (buffer->len + len + 1 > buffer->capacity)
+    {
+        size_t capacity = buffer->capacity ? buffer->capacity : 1024;
+
+        while (buffer->len + len + 1 > capacity) capacity *= 2;
+
+        buffer->data     = (char*)realloc(buffer->data, capacity);
+        buffer->capacity = capacity;
+
+        assert(buffer->data);
+    }
+
+    memcpy(buffer->data + buffer->len, str, len);
+
+    buffer->len += len;
+    buffer->data[buffer->len] = '\0';
+}
+
+static void shader_buffer_append_string(shader_buffer_t* buffer, const char* str) { shader_buffer_append(buffer, str, strlen(str)); }
+
+static bool shader_line_starts_with(const char* line, const char* line_end, const char* tag)
+{
+    size_t len = strlen(tag);
+
+    return (size_t)(line_end - line) >= len && strncmp(line, tag, len) == 0;
 }
 
-static void prepend_version(char* shader)
+static void shader_begin_stage(shader_builder_t* builder, shader_buffer_t* stage, bool is_fragment)
 {
+    builder->stage = stage;
+
 #ifdef __EMSCRIPTEN__
-    strcat(shader, "#version 300 es");
+    shader_buffer_append_string(stage, "#version 300 es\n");
+    if (is_fragment) shader_buffer_append_string(stage, "precision mediump float;\n");
 #else
-    strcat(shader, "#version 330 core");
+    shader_buffer_append_string(stage, "#version 330 core\n");
 #endif
-    strcat(shader, "\n");
+
+    // a variant is the same source compiled
+    // with its upper cased name defined
+    if (builder->desc.variant)
+    {
+        shader_buffer_append_string(stage, "#define ");
+
+        for (const char* c = builder->desc.variant; *c; ++c)
+        {
+            char upper = (*c >= 'a' && *c <= 'z') ? *c - 'a' + 'A' : *c;
+            shader_buffer_append(stage, &upper, 1);
+        }
+
+        shader_buffer_append_string(stage, "\n");
+    }
 }
 
-shader_t* shader_new(const char* filepath)
+static void shader_include(shader_builder_t* builder, const char* line, const char* line_end, int depth)
 {
-    shader_t* shader = (shader_t*)malloc(sizeof(shader_t));
+    const char* name_start = memchr(line, '"', line_end - line);
+    const char* name_end   = name_start ? memchr(name_start + 1, '"', line_end - name_start - 1) : NULL;
 
-    if (shader != NULL)
+    char name[SHADER_MAX_INCLUDE_NAME];
+
+    if (!name_end || (size_t)(name_end - name_start - 1) >= sizeof(name) || !builder->desc.include || depth >= SHADER_MAX_INCLUDE_DEPTH)
+    {
+        builder->failed = true;
+        return;
+    }
+
+    memcpy(name, name_start + 1, name_end - name_start - 1);
+    name[name_end - name_start - 1] = '\0';
+
+    size_t size;
+    char*  chunk = builder->desc.include(name, &size, builder->desc.data);
+
+    if (!chunk)
+    {
+#ifdef DEBUG
+        printf("[SHADER] Missing include \"%s\"\n", name);
+#endif
+        builder->failed = true;
+        return;
+    }
+
+    shader_preprocess(builder, chunk, size, depth + 1);
+
+    free(chunk);
+}
+
+// one pass over the source, stage tags switch the
+// output buffer and includes are expanded in place
+static void shader_preprocess(shader_builder_t* builder, const char* source, size_t size, int depth)
+{
+    const char* cursor = source;
+    const char* end    = source + size;
+
+    while (cursor < end && !builder->failed)
     {
-        char  line[SHADER_MAX_LINE_LENGTH];
-        char  vs[SHADER_MAX_LINE_COUNT] = "";
-        char  fs[SHADER_MAX_LINE_COUNT] = "";
-        char* curr_shader               = NULL;
+        const char* newline    = memchr(cursor, '\n', end - cursor);
+        const char* line_end   = newline ? newline + 1 : end;
+        const char* line_start = cursor;
+        const char* line       = cursor;
+
+        cursor = line_end;
 
-        FILE* file = fopen(filepath, "rb");
+        while (line < line_end && (*line == ' ' || *line == '\t')) ++line;
 
-        if (!file)
+        if (shader_line_starts_with(line, line_end, VERTEX_SHADER_TAG))
         {
-            free(shader);
-            return NULL;
+            shader_begin_stage(builder, &builder->vs, false);
+            continue;
         }
 
-        shader->uniforms_len = 0U;
+        if (shader_line_starts_with(line, line_end, FRAGMENT_SHADER_TAG))
+        {
+            shader_begin_stage(builder, &builder->fs, true);
+            continue;
+        }
 
-        while (fgets(line, sizeof(line), file))
+        if (shader_line_starts_with(line, line_end, VARIANT_TAG)) continue;
+
+        // lines outside of a stage are dropped
+        if (!builder->stage) continue;
+
+        if (shader_line_starts_with(line, line_end, INCLUDE_DIRECTIVE))
         {
-            if (strstr(line, VERTEX_SHADER_TAG))
-            {
-                curr_shader = vs;
+            shader_include(builder, line, line_end, depth);
+            continue;
+        }
 
-                prepend_version(curr_shader);
+        shader_buffer_append(builder->stage, line_start, line_end - line_start);
 
-                continue;
-            }
+        if (!newline) shader_buffer_append_string(builder->stage, "\n");
+    }
+}
 
-            if (strstr(line, FRAGMENT_SHADER_TAG))
-            {
-                curr_shader = fs;
+static int shader_compare_uniform(const void* a, const void* b)
+{
+    return strcmp(((const shader_uniform_info_t*)a)->name, ((const shader_uniform_info_t*)b)->name);
+}
 
-                prepend_version(curr_shader);
-                prepend_precision(curr_shader);
+// active uniforms are read once after linking into
+// one block, sorted by name for the lookups at init
+static void shader_reflect_uniforms(shader_t* shader)
+{
+    int len = renderer_shader_get_uniforms_len(shader->id);
 
-                continue;
-            }
+    if (len <= 0) return;
 
-            if (curr_shader)
-            {
-                strcat(curr_shader, line);
-            }
-        }
+    char (*names)[SHADER_MAX_UNIFORM_NAME] = malloc(len * SHADER_MAX_UNIFORM_NAME);
+    shader_uniform_info_t* infos           = malloc(len * sizeof(shader_uniform_info_t));
 
-        shader->id = renderer_shader_generate(vs, fs);
+    assert(names && infos);
 
-        for (int i = 0; i < shader->uniforms_len; ++i)
-        {
-            int location = renderer_shader_get_uniform_location(shader->id, shader->uniforms[i].name);
+    size_t names_size = 0;
+    size_t infos_len  = 0;
 
-            shader->uniforms[i].location = location;
-        }
+    for (int i = 0; i < len; ++i)
+    {
+        shader_uniform_info_t* info = &infos[infos_len];
+        char*                  name = names[infos_len];
+
+        name[0]    = '\0';
+        info->type = renderer_shader_get_uniform(shader->id, i, name, SHADER_MAX_UNIFORM_NAME, &info->count);
+
+        // arrays are reported as "name[0]"
+        char* bracket = strchr(name, '[');
+        if (bracket) *bracket = '\0';
+
+        info->location = renderer_shader_get_uniform_location(shader->id, name);
+        info->cached   = false;
+
+        if (info->location < 0) continue;
+
+        names_size += strlen(name) + 1;
+        ++infos_len;
+    }
+
+    shader->uniforms     = malloc(infos_len * sizeof(shader_uniform_info_t) + names_size);
+    shader->uniforms_len = infos_len;
+
+    assert(shader->uniforms);
+
+    char* cursor = (char*)(shader->uniforms + infos_len);
+
+    for (size_t i = 0; i < infos_len; ++i)
+    {
+        size_t name_len = strlen(names[i]) + 1;
+
+        memcpy(cursor, names[i], name_len);
 
-        fclose(file);
+        shader->uniforms[i]      = infos[i];
+        shader->uniforms[i].name = cursor;
+
+        cursor += name_len;
+    }
+
+    qsort(shader->uniforms, infos_len, sizeof(shader_uniform_info_t), shader_compare_uniform);
+
+    free(names);
+    free(infos);
+}
+
+static shader_uniform_t shader_find_uniform(shader_t* shader, const char* name)
+{
+    size_t low  = 0;
+    size_t high = shader->uniforms_len;
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        int    order  = strcmp(shader->uniforms[middle].name, name);
+
+        if (order == 0) return (shader_uniform_t)middle;
+
+        if (order < 0) low = middle + 1;
+        else high = middle;
     }
 
+    return SHADER_UNIFORM_NONE;
+}
+
+// includes of a shader loaded straight from a
+// file are looked up next to that file
+static char* shader_include_file(const char* name, size_t* size, void* data)
+{
+    const char* filepath = (const char*)data;
+    const char* slash    = strrchr(filepath, '/');
+    size_t      dir_len  = slash ? (size_t)(slash - filepath + 1) : 0;
+
+    char include_filepath[4096];
+
+    if (dir_len + strlen(name) >= sizeof(include_filepath)) return NULL;
+
+    memcpy(include_filepath, filepath, dir_len);
+    strcpy(include_filepath + dir_len, name);
+
+    return filesystem_read_file(include_filepath, size);
+}
+
+shader_t* shader_new(const char* filepath)
+{
+    size_t size;
+    char*  source = filesystem_read_file(filepath, &size);
+
+    if (!source)
+    {
+        return NULL;
+    }
+
+    shader_t* shader = shader_new_from_desc((shader_desc_t){
+        .source  = source,
+        .size    = size,
+        .include = shader_include_file,
+        .data    = (void*)filepath,
+    });
+
+    free(source);
+
+    return shader;
+}
+
+shader_t* shader_new_from_memory(const char* source, size_t size)
+{
+    return shader_new_from_desc((shader_desc_t){
+        .source = source,
+        .size   = size,
+    });
+}
+
+shader_t* shader_new_from_desc(shader_desc_t desc)
+{
+    shader_t* shader = shader_submit(desc);
+
+    if (shader != NULL && !shader_finish(shader))
+    {
+        free(shader);
+        shader = NULL;
+    }
+
+    return shader;
+}
+
+shader_t* shader_submit(shader_desc_t desc)
+{
+    shader_builder_t builder = {.desc = desc};
+
+    shader_preprocess(&builder, desc.source, desc.size, 0);
+
+    shader_t* shader = NULL;
+
+    if (!builder.failed && builder.vs.data && builder.fs.data)
+    {
+        shader = (shader_t*)malloc(sizeof(shader_t));
+    }
+
+    if (shader != NULL)
+    {
+        shader->uniforms_len = 0U;
+        shader->uniforms     = NULL;
+        shader->id           = renderer_shader_submit(builder.vs.data, builder.fs.data);
+    }
+
+    free(builder.vs.data);
+    free(builder.fs.data);
+
     return shader;
 }
 
+bool shader_ready(shader_t* shader)
+{
+    return renderer_shader_ready(shader->id);
+}
+
+bool shader_finish(shader_t* shader)
+{
+    if (!renderer_shader_finish(shader->id))
+    {
+        shader->id = 0;
+
+        return false;
+    }
+
+    shader_reflect_uniforms(shader);
+
+    return true;
+}
+
+size_t shader_get_variants(const char* source, size_t size, char (*variants)[SHADER_MAX_VARIANT_NAME])
+{
+    size_t len = 0;
+
+    const char* cursor = source;
+    const char* end    = source + size;
+
+    while (cursor < end && len < SHADER_MAX_VARIANTS)
+    {
+        const char* newline  = memchr(cursor, '\n', end - cursor);
+        const char* line_end = newline ? newline : end;
+        const char* line     = cursor;
+
+        cursor = newline ? newline + 1 : end;
+
+        while (line < line_end && (*line == ' ' || *line == '\t')) ++line;
+
+        if (!shader_line_starts_with(line, line_end, VARIANT_TAG)) continue;
+
+        const char* name = line + strlen(VARIANT_TAG);
+
+        while (name < line_end && (*name == ' ' || *name == '\t')) ++name;
+
+        size_t name_len = 0;
+
+        while (name + name_len < line_end && name[name_len] > ' ') ++name_len;
+
+        if (name_len == 0 || name_len >= SHADER_MAX_VARIANT_NAME) continue;
+
+        memcpy(variants[len], name, name_len);
+        variants[len][name_len] = '\0';
+
+        ++len;
+    }
+
+    return len;
+}
+
+bool shader_reload(shader_t* shader, shader_desc_t desc)
+{
+    shader_t* reloaded = shader_new_from_desc(desc);
+
+    if (reloaded == NULL)
+    {
+        return false;
+    }
+
+    // handles index the old table, so its entries
+    // stay and only pick up the new locations
+    for (size_t i = 0; i < shader->uniforms_len; ++i)
+    {
+        shader_uniform_info_t* uniform = &shader->uniforms[i];
+        shader_uniform_t       index   = shader_find_uniform(reloaded, uniform->name);
+
+        uniform->location = index != SHADER_UNIFORM_NONE ? reloaded->uniforms[index].location : -1;
+        uniform->cached   = false;
+    }
+
+    // the program is swapped in place so every
+    // pointer to the shader sees the new one
+    renderer_shader_delete(shader->id);
+
+    shader->id = reloaded->id;
+
+    free(reloaded->uniforms);
+    free(reloaded);
+
+    return true;
+}
+
 void shader_delete(shader_t* shader)
 {
     renderer_shader_delete(shader->id);
+    free(shader->uniforms);
     free(shader);
 }
 
-static int get_cached_uniform_location(shader_t* shader, const char* name)
+shader_uniform_t shader_get_uniform(shader_t* shader, const char* name)
+{
+    shader_uniform_t uniform = shader_find_uniform(shader, name);
+
+#ifdef DEBUG
+    if (uniform == SHADER_UNIFORM_NONE) printf("[SHADER] No active uniform \"%s\"\n", name);
+#endif
+
+    return uniform;
+}
+
+static int shader_get_location(shader_t* shader, shader_uniform_t uniform, UNIFORM_TYPE type)
+{
+    if (uniform == SHADER_UNIFORM_NONE) return -1;
+
+    assert(uniform < shader->uniforms_len);
+    assert(shader->uniforms[uniform].type == type);
+
+    return shader->uniforms[uniform].location;
+}
+
+// uniforms live in the program, so the last value is
+// kept per shader and compared before each upload
+static bool shader_update_value(shader_t* shader, shader_uniform_t uniform, const void* value, size_t size)
 {
-    for (int i = 0; i < shader->uniforms_len; ++i)
+    if (uniform == SHADER_UNIFORM_NONE) return false;
+
+    shader_uniform_info_t* info = &shader->uniforms[uniform];
+
+    if (size > sizeof(info->value))
     {
-        if (strcmp(shader->uniforms[i].name, name) == 0)
-        {
-            return shader->uniforms[i].location;
-        }
+        ++shader_stats.uploads;
+        return true;
     }
 
-    size_t uniforms_len = shader->uniforms_len;
-    assert(uniforms_len < SHADER_MAX_UNIFORMS);
+    if (info->cached && memcmp(info->value, value, size) == 0)
+    {
+        ++shader_stats.skipped;
+        return false;
+    }
 
-    int location = renderer_shader_get_uniform_location(shader->id, name);
+    memcpy(info->value, value, size);
+    info->cached = true;
 
-    assert(location > -1);
+    ++shader_stats.uploads;
+    return true;
+}
 
-    shader->uniforms[uniforms_len].location = location;
-    strcpy(shader->uniforms[uniforms_len].name, name);
-    ++shader->uniforms_len;
+void shader_apply_uniformi(shader_t* shader, shader_uniform_t uniform, int value)
+{
+    int location = shader_get_location(shader, uniform, UNIFORM_INT);
+    if (shader_update_value(shader, uniform, &value, sizeof(int))) renderer_shader_set_uniformi(location, value);
+}
 
-    return location;
+void shader_apply_uniformf(shader_t* shader, shader_uniform_t uniform, float value)
+{
+    int location = shader_get_location(shader, uniform, UNIFORM_FLOAT);
+    if (shader_update_value(shader, uniform, &value, sizeof(float))) renderer_shader_set_uniformf(location, value);
 }
 
-void shader_apply_uniformi(shader_t* shader, const char* name, int value)
+void shader_apply_uniform2f(shader_t* shader, shader_uniform_t uniform, float* value)
 {
-    int location = get_cached_uniform_location(shader, name);
-    renderer_shader_set_uniformi(location, value);
+    int location = shader_get_location(shader, uniform, UNIFORM_VEC2);
+    if (shader_update_value(shader, uniform, value, 2 * sizeof(float))) renderer_shader_set_uniform2f(location, value);
 }
 
-void shader_apply_uniformf(shader_t* shader, const char* name, float value)
+void shader_apply_uniform3f(shader_t* shader, shader_uniform_t uniform, float* value)
 {
-    int location = get_cached_uniform_location(shader, name);
-    renderer_shader_set_uniformf(location, value);
+    int location = shader_get_location(shader, uniform, UNIFORM_VEC3);
+    if (shader_update_value(shader, uniform, value, 3 * sizeof(float))) renderer_shader_set_uniform3f(location, value);
 }
 
-void shader_apply_uniform2f(shader_t* shader, const char* name, float* value)
+void shader_apply_uniform4f(shader_t* shader, shader_uniform_t uniform, float* value)
 {
-    int location = get_cached_uniform_location(shader, name);
-    renderer_shader_set_uniform2f(location, value);
+    int location = shader_get_location(shader, uniform, UNIFORM_VEC4);
+    if (shader_update_value(shader, uniform, value, 4 * sizeof(float))) renderer_shader_set_uniform4f(location, value);
 }
 
-void shader_apply_uniform3f(shader_t* shader, const char* name, float* value)
+void shader_apply_uniformfv(shader_t* shader, shader_uniform_t uniform, size_t len, float* value)
 {
-    int location = get_cached_uniform_location(shader, name);
-    renderer_shader_set_uniform3f(location, value);
+    int location = shader_get_location(shader, uniform, UNIFORM_FLOAT);
+    if (shader_update_value(shader, uniform, value, len * sizeof(float))) renderer_shader_set_uniformfv(location, len, value);
 }
 
-void shader_apply_uniform4f(shader_t* shader, const char* name, float* value)
+void shader_apply_uniform4x4f(shader_t* shader, shader_uniform_t uniform, float* value)
 {
-    int location = get_cached_uniform_location(shader, name);
-    renderer_shader_set_uniform4f(location, value);
+    int location = shader_get_location(shader, uniform, UNIFORM_MAT4);
+    if (shader_update_value(shader, uniform, value, 16 * sizeof(float))) renderer_shader_set_uniform4x4f(location, value);
 }
 
-void shader_apply_uniformfv(shader_t* shader, const char* name, size_t len, float* value)
+shader_stats_t shader_get_stats(void)
 {
-    int location = get_cached_uniform_location(shader, name);
-    renderer_shader_set_uniformfv(location, len, value);
+    return shader_stats;
 }
 
-void shader_apply_uniform4x4f(shader_t* shader, const char* name, float* value)
+void shader_reset_stats(void)
 {
-    int location = get_cached_uniform_location(shader, name);
-    renderer_shader_set_uniform4x4f(location, value);
+    shader_stats = (shader_stats_t){0};
 }
@@ -11,38 +11,93 @@
 #ifndef GRAPHICS_SHADER_H
 #define GRAPHICS_SHADER_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
-#define SHADER_MAX_UNIFORMS     (256)
-#define SHADER_MAX_UNIFORM_NAME (32)
+#define SHADER_MAX_UNIFORM_NAME (64)
+#define SHADER_UNIFORM_NONE     (-1)
+
+#define SHADER_MAX_VARIANTS      (8)
+#define SHADER_MAX_VARIANT_NAME  (32)
+#define SHADER_MAX_INCLUDE_NAME  (256)
+#define SHADER_MAX_INCLUDE_DEPTH (8)
+#define SHADER_MAX_UNIFORM_VALUE (16)
 
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+    // handles index the shader's uniform table, they're
+    // resolved once by name and stay valid across reloads
+    typedef int32_t shader_uniform_t;
+
+    typedef struct shader_uniform_info_t
+    {
+        const char* name;
+        int32_t     location;
+        int32_t     count;
+        uint8_t     type;
+        bool        cached;                            // value holds the last upload
+        float       value[SHADER_MAX_UNIFORM_VALUE];  // ints are kept bitwise
+    } shader_uniform_info_t;
+
+    typedef struct shader_stats_t
+    {
+        uint64_t uploads;
+        uint64_t skipped;
+    } shader_stats_t;
+
     typedef struct shader_t
     {
-        uint32_t id;
-        size_t   uniforms_len;
-        struct
-        {
-            int  location;
-            char name[SHADER_MAX_UNIFORM_NAME];
-        } uniforms[SHADER_MAX_UNIFORMS];
+        uint32_t               id;
+        size_t                 uniforms_len;
+        shader_uniform_info_t* uniforms;  // sorted by name, names follow the entries
     } shader_t;
 
+    // includes are returned malloc'd,
+    // the preprocessor frees them
+    typedef char* (*shader_include_func)(const char* name, size_t* size, void* data);
+
+    typedef struct shader_desc_t
+    {
+        const char*         source;
+        size_t              size;
+        const char*         variant;  // defined upper cased, null for the base
+        shader_include_func include;
+        void*               data;
+    } shader_desc_t;
+
     shader_t* shader_new(const char* filepath);
+    shader_t* shader_new_from_memory(const char* source, size_t size);
+    shader_t* shader_new_from_desc(shader_desc_t desc);
     void      shader_delete(shader_t* shader);
+    bool      shader_reload(shader_t* shader, shader_desc_t desc);
+
+    // submit hands the program to the driver without waiting, ready
+    // polls it and finish blocks on it, checks the result and reflects
+    // the uniforms
+    shader_t* shader_submit(shader_desc_t desc);
+    bool      shader_ready(shader_t* shader);
+    bool      shader_finish(shader_t* shader);
+
+    size_t shader_get_variants(const char* source, size_t size, char (*variants)[SHADER_MAX_VARIANT_NAME]);
+
+    shader_uniform_t shader_get_uniform(shader_t* shader, const char* name);
+
+    void shader_apply_uniformi(shader_t* shader, shader_uniform_t uniform, int value);
+    void shader_apply_uniformf(shader_t* shader, shader_uniform_t uniform, float value);
+    void shader_apply_uniform2f(shader_t* shader, shader_uniform_t uniform, float* value);
+    void shader_apply_uniform3f(shader_t* shader, shader_uniform_t uniform, float* value);
+    void shader_apply_uniform4f(shader_t* shader, shader_uniform_t uniform, float* value);
+    void shader_apply_uniformfv(shader_t* shader, shader_uniform_t uniform, size_t len, float* value);
+    void shader_apply_uniform4x4f(shader_t* shader, shader_uniform_t uniform, float* value);
 
-    void shader_apply_uniformi(shader_t* shader, const char* name, int value);
-    void shader_apply_uniformf(shader_t* shader, const char* name, float value);
-    void shader_apply_uniform2f(shader_t* shader, const char* name, float* value);
-    void shader_apply_uniform3f(shader_t* shader, const char* name, float* value);
-    void shader_apply_uniform4f(shader_t* shader, const char* name, float* value);
-    void shader_apply_uniformfv(shader_t* shader, const char* name, size_t len, float* value);
-    void shader_apply_uniform4x4f(shader_t* shader, const char* name, float* value);
+    // applies equal to the last value of a uniform are
+    // skipped, the counts are totals since the last reset
+    shader_stats_t shader_get_stats(void);
+    void           shader_reset_stats(void);
 
 #ifdef __cplusplus
 }
@@ -38,6 +38,26 @@ texture_t* texture_new_from_file(const char* path)
     return texture;
 }
 
+texture_t* texture_new_from_memory(const uint8_t* data, size_t size)
+{
+    texture_t* texture = (texture_t*)malloc(sizeof(texture_t));
+
+    if (texture != NULL)
+    {
+        int width;
+        int height;
+        int bpp;
+
+        uint8_t* pixels = stbi_load_from_memory(data, (int)size, &width, &height, &bpp, STBI_rgb_alpha);
+
+        texture->pixels = pixels;
+        texture->width  = width;
+        texture->height = height;
+    }
+
+    return texture;
+}
+
 texture_t* texture_new_from_data(uint8_t* pixels, int width, int height)
 {
     texture_t* texture = (texture_t*)malloc(sizeof(texture_t));
@@ -11,6 +11,7 @@
 #ifndef GRAPHICS_TEXTURE_H
 #define GRAPHICS_TEXTURE_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -26,6 +27,7 @@ extern "C"
     } texture_t;
 
     texture_t* texture_new_from_file(const char* path);
+    texture_t* texture_new_from_memory(const uint8_t* data, size_t size);
     texture_t* texture_new_from_data(uint8_t* pixels, int width, int height);
     texture_t* texture_new_empty(int width, int height);
     void       texture_delete(texture_t* texture);
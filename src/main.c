@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #ifdef __EMSCRIPTEN__
@@ -20,8 +21,10 @@
 
 #include "game/game.h"
 
+#include "platform/content.h"
 #include "platform/input.h"
 #include "platform/platform.h"
+#include "platform/trace.h"
 
 #include "graphics/renderer.h"
 
@@ -104,6 +107,8 @@ static void app_step(void)
         app_events(event);
     }
 
+    content_begin_frame();
+
     while (accumulator >= frame_time)
     {
         app_update();
@@ -112,6 +117,8 @@ static void app_step(void)
     }
 
     app_render();
+
+    content_end_frame();
     platform_swap_window();
 }
 
@@ -132,12 +139,22 @@ static void app_resize(void)
 
 int main(int argc, char* argv[])
 {
-    (void)argc;
-    (void)argv;
+    // --render-audio <commands> <out.wav> mixes
+    // offline and exits before any window opens
+    if (argc == 4 && strcmp(argv[1], "--render-audio") == 0)
+    {
+        return game_render_audio(argv[2], argv[3]);
+    }
+
+    trace_init();
+
+    TRACE_BEGIN("platform_create_window");
 
     void* window  = platform_create_window("game", WIDTH, HEIGHT);
     void* context = platform_create_context(window);
 
+    TRACE_END();
+
     assert(window);
     assert(context);
 
@@ -160,5 +177,7 @@ int main(int argc, char* argv[])
     app_shutdown();
     platform_shutdown();
 
+    trace_shutdown();
+
     return EXIT_SUCCESS;
 }
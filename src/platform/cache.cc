@@ -0,0 +1,185 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______   ______   ______   __  __   ______     //
+//  /\  ___\ /\  __ \ /\  ___\ /\ \_\ \ /\  ___\    //
+//  \ \ \____\ \  __ \\ \ \____\ \  __ \\ \  __\    //
+//   \ \_____\\ \_\ \_\\ \_____\\ \_\ \_\\ \_____\  //
+//    \/_____/ \/_/\/_/ \/_____/ \/_/\/_/ \/_____/  //
+//                                                  //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// platform/cache.cc
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "platform/cache.h"
+
+struct cache_t
+{
+    std::string path;
+};
+
+static std::string cache_get_filepath(cache_t* cache, uint64_t key, const char* extension)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/%016llx%s", (unsigned long long)key, extension);
+
+    return cache->path + name;
+}
+
+static const uint8_t* cache_map(const char* filepath, size_t* size)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file, &file_size);
+
+    HANDLE mapping = file_size.QuadPart > 0 ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    void*  data    = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+
+    // the view keeps the file
+    // mapped once handles close
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+
+    *size = (size_t)file_size.QuadPart;
+
+    return (const uint8_t*)data;
+#else
+    int file = open(filepath, O_RDONLY);
+
+    if (file < 0) return NULL;
+
+    struct stat status;
+
+    if (fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        close(file);
+        return NULL;
+    }
+
+    void* data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+    close(file);
+
+    if (data == MAP_FAILED) return NULL;
+
+    *size = (size_t)status.st_size;
+
+    return (const uint8_t*)data;
+#endif
+}
+
+static void cache_unmap(const uint8_t* data, size_t size)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+#else
+    munmap((void*)data, size);
+#endif
+}
+
+cache_t* cache_open(const char* path)
+{
+#ifdef __EMSCRIPTEN__
+    // nothing persists between
+    // runs on the web build
+    return NULL;
+#else
+    std::error_code error;
+
+    std::filesystem::create_directories(path, error);
+
+    if (!std::filesystem::is_directory(path, error)) return NULL;
+
+    return new cache_t{std::string(path)};
+#endif
+}
+
+void cache_close(cache_t* cache) { delete cache; }
+
+uint64_t cache_hash(const void* data, size_t size, uint64_t seed)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+
+    uint64_t hash = 14695981039346656037ull ^ seed;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+const void* cache_read(cache_t* cache, uint64_t key, uint64_t stamp, size_t* size)
+{
+    size_t         mapped_size;
+    const uint8_t* data = cache_map(cache_get_filepath(cache, key, ".bin").c_str(), &mapped_size);
+
+    if (data == NULL) return NULL;
+
+    const cache_header_t* header = (const cache_header_t*)data;
+
+    bool is_valid = mapped_size >= sizeof(cache_header_t) && header->magic == CACHE_MAGIC && header->version == CACHE_VERSION;
+    is_valid = is_valid && header->key == key && header->stamp == stamp && header->size == mapped_size - sizeof(cache_header_t);
+
+    if (!is_valid)
+    {
+        cache_unmap(data, mapped_size);
+        return NULL;
+    }
+
+    *size = (size_t)header->size;
+
+    return data + sizeof(cache_header_t);
+}
+
+void cache_release(cache_t* cache, const void* data, size_t size)
+{
+    cache_unmap((const uint8_t*)data - sizeof(cache_header_t), size + sizeof(cache_header_t));
+}
+
+bool cache_write(cache_t* cache, uint64_t key, uint64_t stamp, const void* head, size_t head_size, const void* data, size_t size)
+{
+    std::string filepath      = cache_get_filepath(cache, key, ".bin");
+    std::string temp_filepath = cache_get_filepath(cache, key, ".tmp");
+
+    FILE* file = fopen(temp_filepath.c_str(), "wb");
+
+    if (file == NULL) return false;
+
+    cache_header_t header = {CACHE_MAGIC, CACHE_VERSION, key, stamp, head_size + size};
+
+    bool is_written = fwrite(&header, sizeof(header), 1, file) == 1;
+    is_written = is_written && (head_size == 0 || fwrite(head, head_size, 1, file) == 1);
+    is_written = is_written && (size == 0 || fwrite(data, size, 1, file) == 1);
+    is_written = fclose(file) == 0 && is_written;
+
+    std::error_code error;
+
+    // entries are written aside and renamed, a
+    // reader never maps a half written file
+    if (is_written) std::filesystem::rename(temp_filepath, filepath, error);
+
+    bool is_renamed = is_written && !error;
+
+    if (!is_renamed) std::filesystem::remove(temp_filepath, error);
+
+    return is_renamed;
+}
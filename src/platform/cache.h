@@ -0,0 +1,54 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______   ______   ______   __  __   ______     //
+//  /\  ___\ /\  __ \ /\  ___\ /\ \_\ \ /\  ___\    //
+//  \ \ \____\ \  __ \\ \ \____\ \  __ \\ \  __\    //
+//   \ \_____\\ \_\ \_\\ \_____\\ \_\ \_\\ \_____\  //
+//    \/_____/ \/_/\/_/ \/_____/ \/_/\/_/ \/_____/  //
+//                                                  //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// platform/cache.h
+
+#ifndef PLATFORM_CACHE_H
+#define PLATFORM_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CACHE_MAGIC   (0x48434143u)  // "CACH"
+#define CACHE_VERSION (1u)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct cache_t cache_t;
+
+    // every entry is a file named after its key, the
+    // stamp ties it to the source it was decoded from
+    typedef struct cache_header_t
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint64_t stamp;
+        uint64_t size;
+    } cache_header_t;
+
+    cache_t* cache_open(const char* path);
+    void     cache_close(cache_t* cache);
+
+    uint64_t cache_hash(const void* data, size_t size, uint64_t seed);
+
+    // entries are mapped read only and stay valid until
+    // released, a stale or missing entry returns null
+    const void* cache_read(cache_t* cache, uint64_t key, uint64_t stamp, size_t* size);
+    void        cache_release(cache_t* cache, const void* data, size_t size);
+    bool        cache_write(cache_t* cache, uint64_t key, uint64_t stamp, const void* head, size_t head_size, const void* data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // PLATFORM_CACHE_H
@@ -8,13 +8,25 @@
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
 // platform/content.c
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstdio>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "platform/content.h"
 #include "platform/platform.h"
 #include "platform/filesystem.h"
+#include "platform/pack.h"
+#include "platform/cache.h"
+#include "platform/trace.h"
 
 #include "graphics/shader.h"
 #include "graphics/atlas.h"
@@ -22,126 +34,985 @@
 
 #include "audio/sound.h"
 
-using file_action_func = void(const char* filename, const char* filepath, void* data);
-
-static void content_load_asset(const char* path, const char* extension, void* data, file_action_func action);
-
-#define CONTENT_DEFINE(type, extension, path, name)                                        \
-    static std::unordered_map<std::string, type> name;                                     \
-                                                                                           \
-    static void asset_load_##name(const char* filename, const char* filepath, void* data); \
-    static void asset_unload_##name(type& asset);                                          \
-                                                                                           \
-    void content_load_##name(void)                                                         \
-    {                                                                                      \
-        name.clear();                                                                      \
-        content_load_asset(path, extension, NULL, asset_load_##name);                      \
-    }                                                                                      \
-                                                                                           \
-    void content_load_##name##_ex(void* data)                                              \
-    {                                                                                      \
-        name.clear();                                                                      \
-        content_load_asset(path, extension, data, asset_load_##name);                      \
-    }                                                                                      \
-                                                                                           \
-    void content_unload_##name(void)                                                       \
-    {                                                                                      \
-        for (auto& [key, value] : name)                                                    \
-        {                                                                                  \
-            asset_unload_##name(value);                                                    \
-        }                                                                                  \
-        name.clear();                                                                      \
-    }                                                                                      \
-                                                                                           \
-    bool content_find_##name(const char* filename, type* asset)                            \
-    {                                                                                      \
-        if (name.find(std::string(filename)) != name.end())                                \
-        {                                                                                  \
-            *asset = name[std::string(filename)];                                          \
-            return true;                                                                   \
-        }                                                                                  \
-        return false;                                                                      \
+struct content_file_t
+{
+    const char* filename;
+    const char* filepath;
+    const void* contents;  // null when the file is read from disk
+    size_t      size;
+    size_t      entry;
+    void*       decoded;
+};
+
+using file_decode_func  = void*(const content_file_t& file);
+using file_action_func  = void(const content_file_t& file, void* data);
+using file_discard_func = void(void* decoded);
+
+struct content_job_t
+{
+    std::thread                          thread;
+    std::atomic<bool>                    collected{false};
+    std::atomic<bool>                    cancelled{false};
+    std::vector<content_file_t>          files;
+    std::unique_ptr<std::atomic<bool>[]> decoded;
+
+    size_t applied = 0;
+    void*  data    = NULL;
+};
+
+#define CONTENT_ARENA_BLOCK (16 * 1024)
+
+#define CONTENT_SHADER_INCLUDE_EXTENSION (".glsl")
+
+enum content_type_t
+{
+#define X(type, extension, path, name) CONTENT_TYPE_##name,
+    CONTENT_TYPES
+#undef X
+    CONTENT_TYPE_LEN
+};
+
+struct content_extension_t
+{
+    const char*    extension;
+    size_t         len;
+    content_type_t type;
+};
+
+struct content_image_t
+{
+    texture_t   texture;
+    const void* cached;  // cache entry backing the pixels
+    size_t      cached_size;
+};
+
+struct content_image_head_t
+{
+    int32_t width;
+    int32_t height;
+};
+
+struct content_entry_t
+{
+    const char* filename;
+    const char* filepath;
+    size_t      entry;
+};
+
+static const char* const content_type_paths[] = {
+#define X(type, extension, path, name) path,
+    CONTENT_TYPES
+#undef X
+};
+
+static const char* const content_type_extensions[] = {
+#define X(type, extension, path, name) extension,
+    CONTENT_TYPES
+#undef X
+};
+
+static pack_t*             content_pack;
+static cache_t*            content_cache;
+static filesystem_watch_t* content_watch;
+
+static std::string                      content_root;
+static std::vector<content_extension_t> content_extensions;
+static std::vector<content_entry_t>     content_entries[CONTENT_TYPE_LEN];
+
+static std::vector<char*> content_arena;
+static size_t             content_arena_used = CONTENT_ARENA_BLOCK;
+
+static std::vector<shader_t*> content_pending_shaders;
+
+static void content_load_asset(content_type_t type, void* data, file_decode_func* decode, file_action_func action);
+static void content_start_job(content_job_t& job, content_type_t type, void* data, file_decode_func* decode);
+static bool content_poll_job(content_job_t& job, double budget, float* progress, file_decode_func* decode, file_action_func action);
+static void content_cancel_job(content_job_t& job, file_discard_func* discard);
+
+// packed files are stamped by their contents,
+// loose files by their size and write time
+static uint64_t content_get_stamp(const content_file_t& file)
+{
+    uint64_t stat[2] = {};
+
+    if (file.contents) return cache_hash(file.contents, file.size, 0);
+    if (!filesystem_get_file_stat(file.filepath, &stat[0], &stat[1])) return 0;
+
+    return cache_hash(stat, sizeof(stat), 0);
+}
+
+static bool content_read_image(content_image_t* image, uint64_t key, uint64_t stamp)
+{
+    size_t         size;
+    const uint8_t* cached = (const uint8_t*)cache_read(content_cache, key, stamp, &size);
+
+    if (!cached) return false;
+
+    content_image_head_t head;
+    memcpy(&head, cached, sizeof(head));
+
+    if (size != sizeof(head) + (size_t)head.width * head.height * 4)
+    {
+        cache_release(content_cache, cached, size);
+        return false;
+    }
+
+    image->texture     = {head.width, head.height, (uint8_t*)(cached + sizeof(head))};
+    image->cached      = cached;
+    image->cached_size = size;
+
+    return true;
+}
+
+static void* asset_decode_texture(const content_file_t& file)
+{
+    content_image_t* image = new content_image_t();
+
+    uint64_t key   = cache_hash(file.filepath, strlen(file.filepath), 0);
+    uint64_t stamp = content_cache ? content_get_stamp(file) : 0;
+
+    // warm starts map the pixels decoded by an
+    // earlier run instead of decoding the png
+    if (content_cache && stamp && content_read_image(image, key, stamp)) return image;
+
+    texture_t* texture = file.contents ? texture_new_from_memory((const uint8_t*)file.contents, file.size) : texture_new_from_file(file.filepath);
+
+    image->texture = *texture;
+    free(texture);
+
+    if (!image->texture.pixels)
+    {
+        delete image;
+        return NULL;
+    }
+
+    if (content_cache && stamp && image->texture.pixels)
+    {
+        content_image_head_t head = {image->texture.width, image->texture.height};
+
+        cache_write(content_cache, key, stamp, &head, sizeof(head), image->texture.pixels, (size_t)head.width * head.height * 4);
+    }
+
+    return image;
+}
+
+static void content_free_image(content_image_t* image)
+{
+    if (image->cached) cache_release(content_cache, image->cached, image->cached_size);
+    else texture_delete_stb(&image->texture);
+
+    delete image;
+}
+
+static sound_t* content_read_sound(uint64_t key, uint64_t stamp)
+{
+    size_t      size;
+    const void* cached = cache_read(content_cache, key, stamp, &size);
+
+    if (!cached) return NULL;
+
+    sound_t* sound = sound_new_from_memory(cached, size);
+
+    cache_release(content_cache, cached, size);
+
+    return sound;
+}
+
+// long tracks stream, straight from the mapping when the
+// pack stores them as is, otherwise from the loose file
+static void* asset_decode_sound(const content_file_t& file)
+{
+    uint64_t size  = file.size;
+    uint64_t mtime = 0;
+
+    if (!file.contents && !filesystem_get_file_stat(file.filepath, &size, &mtime)) return NULL;
+
+    // a long track at another rate than the device's can't
+    // stream, it falls through to be resampled whole instead
+    if (size >= SOUND_STREAM_SIZE)
+    {
+        sound_t* stream = NULL;
+
+        if (!file.contents) stream = sound_new_stream(file.filepath);
+        else if (pack_is_stored(content_pack, file.entry)) stream = sound_new_stream_from_memory(file.contents, file.size);
+
+        if (stream) return stream;
+    }
+
+    // the converted clip is cached per device rate, warm
+    // starts load it as is without resampling again
+    uint64_t key   = cache_hash(file.filepath, strlen(file.filepath), (uint64_t)sound_get_sample_rate());
+    uint64_t stamp = content_cache ? content_get_stamp(file) : 0;
+
+    if (content_cache && stamp)
+    {
+        sound_t* sound = content_read_sound(key, stamp);
+
+        if (sound) return sound;
+    }
+
+    size_t      data_size = file.size;
+    char*       read      = file.contents ? NULL : filesystem_read_file(file.filepath, &data_size);
+    const void* data      = file.contents ? file.contents : read;
+
+    if (!data) return NULL;
+
+    size_t converted_size = 0;
+    void*  converted      = sound_convert(data, data_size, &converted_size);
+
+    if (converted && content_cache && stamp) cache_write(content_cache, key, stamp, NULL, 0, converted, converted_size);
+
+    sound_t* sound = converted ? sound_new_from_memory(converted, converted_size) : sound_new_from_memory(data, data_size);
+
+    free(converted);
+    free(read);
+
+    return sound;
+}
+
+// decoders run on worker threads, anything
+// touching the gl context stays on the main thread
+static file_decode_func* const asset_decode_shaders  = nullptr;
+static file_decode_func* const asset_decode_sounds   = asset_decode_sound;
+static file_decode_func* const asset_decode_textures = asset_decode_texture;
+
+static void asset_discard_sound(void* decoded) { sound_delete((sound_t*)decoded); }
+static void asset_discard_texture(void* decoded) { content_free_image((content_image_t*)decoded); }
+
+// results a cancelled job decoded but never handed over
+static file_discard_func* const asset_discard_shaders  = nullptr;
+static file_discard_func* const asset_discard_sounds   = asset_discard_sound;
+static file_discard_func* const asset_discard_textures = asset_discard_texture;
+
+#ifdef DEBUG
+static bool content_in_frame;
+
+// string lookups belong in init code, anything
+// per frame should hold on to an id instead
+static void content_check_lookup(const char* filename)
+{
+    if (content_in_frame) printf("   - String lookup of \"%s\" during a frame\n", filename);
+}
+#else
+static void content_check_lookup(const char* filename) {}
+#endif
+
+// a file that can't be decoded is left out, finding
+// it by name fails the same as a missing file would
+static void content_report_failed(const char* filepath)
+{
+#ifdef DEBUG
+    printf("   - Failed to decode \"%s\"\n", filepath);
+#endif
+}
+
+static void content_report_reload(const char* filepath)
+{
+#ifdef DEBUG
+    printf("   - Reloaded \"%s\"\n", filepath);
+#endif
+}
+
+void content_begin_frame(void)
+{
+#ifdef DEBUG
+    content_in_frame = true;
+#endif
+}
+
+void content_end_frame(void)
+{
+#ifdef DEBUG
+    content_in_frame = false;
+#endif
+}
+
+#define CONTENT_DEFINE(type, extension, path, name)                                                       \
+    static std::vector<type>                         name;                                                \
+    static std::unordered_map<std::string, uint32_t> name##_ids;                                          \
+    static content_job_t                             name##_job;                                          \
+                                                                                                          \
+    static void asset_load_##name(const content_file_t& file, void* data);                                \
+    static void asset_unload_##name(type& asset);                                                         \
+    static bool asset_reload_##name(type& asset, const content_file_t& file, void* data);                 \
+                                                                                                          \
+    static void asset_insert_##name(const char* filename, type asset)                                     \
+    {                                                                                                     \
+        name##_ids.insert({std::string(filename), (uint32_t)name.size()});                                \
+        name.push_back(asset);                                                                            \
+    }                                                                                                     \
+                                                                                                          \
+    void content_load_##name(void)                                                                        \
+    {                                                                                                     \
+        name.clear();                                                                                     \
+        name##_ids.clear();                                                                               \
+        content_load_asset(CONTENT_TYPE_##name, NULL, asset_decode_##name, asset_load_##name);            \
+    }                                                                                                     \
+                                                                                                          \
+    void content_load_##name##_ex(void* data)                                                             \
+    {                                                                                                     \
+        name.clear();                                                                                     \
+        name##_ids.clear();                                                                               \
+        content_load_asset(CONTENT_TYPE_##name, data, asset_decode_##name, asset_load_##name);            \
+    }                                                                                                     \
+                                                                                                          \
+    void content_load_##name##_async(void* data)                                                          \
+    {                                                                                                     \
+        name.clear();                                                                                     \
+        name##_ids.clear();                                                                               \
+        content_start_job(name##_job, CONTENT_TYPE_##name, data, asset_decode_##name);                    \
+    }                                                                                                     \
+                                                                                                          \
+    bool content_poll_##name(double budget, float* progress)                                              \
+    {                                                                                                     \
+        return content_poll_job(name##_job, budget, progress, asset_decode_##name, asset_load_##name);    \
+    }                                                                                                     \
+                                                                                                          \
+    void content_cancel_##name(void) { content_cancel_job(name##_job, asset_discard_##name); }            \
+                                                                                                          \
+    void content_unload_##name(void)                                                                      \
+    {                                                                                                     \
+        for (auto& value : name)                                                                          \
+        {                                                                                                 \
+            asset_unload_##name(value);                                                                   \
+        }                                                                                                 \
+        name.clear();                                                                                     \
+        name##_ids.clear();                                                                               \
+    }                                                                                                     \
+                                                                                                          \
+    bool content_find_##name(const char* filename, type* asset)                                           \
+    {                                                                                                     \
+        uint32_t id = content_id_##name(filename);                                                        \
+                                                                                                          \
+        if (id != CONTENT_ID_NONE)                                                                        \
+        {                                                                                                 \
+            *asset = name[id];                                                                            \
+            return true;                                                                                  \
+        }                                                                                                 \
+        return false;                                                                                     \
+    }                                                                                                     \
+                                                                                                          \
+    uint32_t content_id_##name(const char* filename)                                                      \
+    {                                                                                                     \
+        content_check_lookup(filename);                                                                   \
+                                                                                                          \
+        auto it = name##_ids.find(filename);                                                              \
+        return it != name##_ids.end() ? it->second : CONTENT_ID_NONE;                                     \
+    }                                                                                                     \
+                                                                                                          \
+    type content_get_##name(uint32_t id)                                                                  \
+    {                                                                                                     \
+        assert(id < name.size());                                                                         \
+        return name[id];                                                                                  \
+    }                                                                                                     \
+                                                                                                          \
+    static void content_reload_##name(const char* filename, const char* filepath, void* data)             \
+    {                                                                                                     \
+        content_file_t file = {};                                                                         \
+                                                                                                          \
+        file.filename = filename;                                                                         \
+        file.filepath = filepath;                                                                         \
+                                                                                                          \
+        auto it = name##_ids.find(filename);                                                              \
+                                                                                                          \
+        if (it != name##_ids.end() && asset_reload_##name(name[it->second], file, data))                  \
+        {                                                                                                 \
+            content_report_reload(filepath);                                                              \
+        }                                                                                                 \
     }
 
 #define X(type, extension, path, name) CONTENT_DEFINE(type, extension, path, name)
 CONTENT_TYPES
 #undef X
 
-static void content_load_asset(const char* path, const char* extension, void* data, file_action_func action)
+static const char* content_arena_push(const char* str, size_t len)
 {
-    size_t       dir_len   = 0;
-    const char** dir_files = NULL;
+    if (len + 1 > CONTENT_ARENA_BLOCK - content_arena_used)
+    {
+        content_arena.push_back((char*)malloc(std::max<size_t>(CONTENT_ARENA_BLOCK, len + 1)));
+        content_arena_used = 0;
+    }
 
-    filesystem_enumerate_dir((std::string(platform_get_path()) + "/assets/" + path).c_str(), &dir_files, &dir_len, true);
+    char* copy = content_arena.back() + content_arena_used;
 
-    for (int i = 0; i < dir_len; ++i)
-    {
-        const char* filepath       = dir_files[i];
-        const char* filename       = filesystem_get_file_name(filepath, false);
-        const char* file_extension = filesystem_get_file_extension(filepath);
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+
+    content_arena_used += len + 1;
 
-        bool is_correct_extension = false;
+    return copy;
+}
+
+static void content_arena_clear(void)
+{
+    for (char* block : content_arena) free(block);
 
-        const char* ext_start = extension;
+    content_arena.clear();
+    content_arena_used = CONTENT_ARENA_BLOCK;
+}
+
+static void content_build_extensions(void)
+{
+    content_extensions.clear();
+
+    // the '|' separated lists are split once,
+    // files are matched against the flat table
+    for (int type = 0; type < CONTENT_TYPE_LEN; ++type)
+    {
+        const char* ext_start = content_type_extensions[type];
 
         while (*ext_start)
         {
             const char* ext_end = strchr(ext_start, '|');
             if (!ext_end) ext_end = ext_start + strlen(ext_start);
 
-            if (strncmp(file_extension, ext_start, ext_end - ext_start) == 0 && file_extension[ext_end - ext_start] == '\0')
-            {
-                is_correct_extension = true;
-                break;
-            }
+            content_extensions.push_back({ext_start, (size_t)(ext_end - ext_start), (content_type_t)type});
 
             ext_start = *ext_end ? ext_end + 1 : ext_end;
         }
+    }
+}
+
+// paths are relative to the assets root, the first
+// directory and the extension decide the content type
+static bool content_classify(const char* path, content_type_t* type, const char** stem, size_t* stem_len)
+{
+    const char* dir_end   = strchr(path, '/');
+    const char* base      = strrchr(path, '/');
+    const char* extension = base ? strrchr(base, '.') : NULL;
+
+    if (!dir_end || !extension) return false;
+
+    for (const auto& entry : content_extensions)
+    {
+        const char* type_path = content_type_paths[entry.type];
+
+        if (strlen(extension) != entry.len || strncmp(extension, entry.extension, entry.len) != 0) continue;
+        if (strlen(type_path) != (size_t)(dir_end - path) || strncmp(path, type_path, dir_end - path) != 0) continue;
+
+        *type     = entry.type;
+        *stem     = base + 1;
+        *stem_len = extension - (base + 1);
+
+        return true;
+    }
+
+    return false;
+}
+
+static void content_add_entry(const char* relative, const char* filepath, size_t entry)
+{
+    content_type_t type;
+    const char*    stem;
+    size_t         stem_len;
+
+    if (!content_classify(relative, &type, &stem, &stem_len)) return;
+
+    content_entries[type].push_back({content_arena_push(stem, stem_len), filepath, entry});
+}
+
+static void content_add_dir_entry(const char* filepath, void* data)
+{
+    size_t len = strlen(filepath);
+
+    char* copy = (char*)content_arena_push(filepath, len);
+
+    for (char* c = copy; *c; ++c)
+        if (*c == '\\') *c = '/';
+
+    content_add_entry(copy + content_root.size() + 1, copy, 0);
+}
+
+bool content_mount(void)
+{
+    TRACE_BEGIN("content_mount");
+
+    content_unmount();
+
+    if (content_extensions.empty()) content_build_extensions();
+
+    content_root  = std::string(platform_get_path()) + "/assets";
+    content_pack  = pack_open((content_root + ".pack").c_str());
+    content_cache = cache_open((std::string(platform_get_path()) + "/cache").c_str());
+
+    for (auto& c : content_root)
+        if (c == '\\') c = '/';
+
+    // one pass over the pack's table or the assets
+    // directory sorts every file into its content type
+    if (content_pack)
+    {
+        for (size_t i = 0; i < pack_get_len(content_pack); ++i) content_add_entry(pack_get_name(content_pack, i), pack_get_name(content_pack, i), i);
+    }
+    else
+    {
+        filesystem_walk_dir(content_root.c_str(), content_add_dir_entry, NULL);
+    }
+
+    TRACE_END();
+
+    return content_pack != NULL;
+}
+
+void content_unmount(void)
+{
+    if (content_pack) pack_close(content_pack);
+
+    if (content_cache) cache_close(content_cache);
+
+    content_pack  = NULL;
+    content_cache = NULL;
+
+    for (auto& entries : content_entries) entries.clear();
+
+    content_arena_clear();
+}
+
+void content_watch_start(void)
+{
+    content_watch = filesystem_watch_new(content_root.c_str());
+}
+
+void content_watch_stop(void)
+{
+    filesystem_watch_delete(content_watch);
+
+    content_watch = NULL;
+}
+
+void content_watch_update(void* data)
+{
+    const char* filepath;
+
+    if (!content_watch) return;
+
+    // every change is handled on the spot, a single
+    // shader or texture takes a few milliseconds
+    while (filesystem_watch_poll(content_watch, &filepath))
+    {
+        content_type_t type;
+        const char*    stem;
+        size_t         stem_len;
+
+        if (strncmp(filepath, content_root.c_str(), content_root.size()) != 0) continue;
+
+        const char* relative  = filepath + content_root.size() + 1;
+        const char* extension = strrchr(relative, '.');
+
+        // any shader may include an edited
+        // chunk, so they're all rebuilt
+        if (extension && strcmp(extension, CONTENT_SHADER_INCLUDE_EXTENSION) == 0)
+        {
+            for (const auto& entry : content_entries[CONTENT_TYPE_shaders]) content_reload_shaders(entry.filename, entry.filepath, data);
+            continue;
+        }
+
+        if (!content_classify(relative, &type, &stem, &stem_len)) continue;
 
-        if (is_correct_extension)
+        std::string filename(stem, stem_len);
+
+        switch (type)
         {
-            action(filename, filepath, data);
+#define X(type, extension, path, name) \
+    case CONTENT_TYPE_##name: content_reload_##name(filename.c_str(), filepath, data); break;
+            CONTENT_TYPES
+#undef X
+            default: break;
+        }
+    }
+}
+
+static void content_collect_files(content_type_t type, std::vector<content_file_t>& files)
+{
+    for (const auto& entry : content_entries[type])
+    {
+        content_file_t file = {};
+
+        file.filename = entry.filename;
+        file.filepath = entry.filepath;
+        file.entry    = entry.entry;
+
+        // a mounted pack replaces the assets directory,
+        // its entries are read straight from the mapping
+        if (content_pack)
+        {
+            file.contents = pack_read(content_pack, entry.entry, &file.size);
+
+            assert(file.contents);
+        }
+
+        files.push_back(file);
+    }
+}
+
+#ifndef __EMSCRIPTEN__
+static std::mutex              content_slots_mutex;
+static std::condition_variable content_slots_ready;
+static int                     content_slots = -1;
+
+// the jobs of every type share one decode per core, each
+// spawns its workers but they wait here for a free slot
+static void content_slot_acquire(void)
+{
+    std::unique_lock<std::mutex> lock(content_slots_mutex);
+
+    if (content_slots < 0) content_slots = (int)std::max(1u, std::thread::hardware_concurrency());
+
+    content_slots_ready.wait(lock, []() { return content_slots > 0; });
+
+    --content_slots;
+}
+
+static void content_slot_release(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(content_slots_mutex);
+        ++content_slots;
+    }
+
+    content_slots_ready.notify_one();
+}
+#endif
+
+static void content_decode_files(std::vector<content_file_t>& files, file_decode_func* decode, std::atomic<bool>* decoded, const std::atomic<bool>* cancelled)
+{
+    if (decode == nullptr)
+    {
+        for (size_t i = 0; decoded && i < files.size(); ++i) decoded[i].store(true, std::memory_order_release);
+        return;
+    }
+
+#ifdef __EMSCRIPTEN__
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        TRACE_BEGIN(files[i].filename);
+        files[i].decoded = decode(files[i]);
+        TRACE_END();
+
+        if (decoded) decoded[i].store(true, std::memory_order_release);
+    }
+#else
+    std::atomic<size_t>      next{0};
+    std::vector<std::thread> workers;
+
+    size_t workers_len = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), files.size());
+
+    // every result lands in its own slot, so the
+    // caller still consumes them in enumeration order
+    for (size_t i = 0; i < workers_len; ++i)
+    {
+        workers.emplace_back([&]() {
+            for (size_t j = next++; j < files.size(); j = next++)
+            {
+                content_slot_acquire();
+
+                if (cancelled && cancelled->load(std::memory_order_acquire))
+                {
+                    content_slot_release();
+                    break;
+                }
+
+                TRACE_BEGIN(files[j].filename);
+                files[j].decoded = decode(files[j]);
+                TRACE_END();
+
+                content_slot_release();
+
+                if (decoded) decoded[j].store(true, std::memory_order_release);
+            }
+        });
+    }
+
+    for (auto& worker : workers) worker.join();
+#endif
+}
+
+static void content_apply_file(content_file_t& file, void* data, file_action_func action)
+{
+    TRACE_BEGIN(file.filepath);
+    action(file, data);
+    TRACE_END();
 #ifdef DEBUG
-            printf("   - Loaded \"%s\"\n", filepath);
+    printf("   - Loaded \"%s\"\n", file.filepath);
 #endif
-        }
+    if (file.contents) pack_release(content_pack, file.entry, file.contents);
+}
+
+static void content_load_asset(content_type_t type, void* data, file_decode_func* decode, file_action_func action)
+{
+    std::vector<content_file_t> files;
+
+    TRACE_BEGIN(content_type_paths[type]);
+
+    content_collect_files(type, files);
+    content_decode_files(files, decode, nullptr, nullptr);
+
+    for (auto& file : files) content_apply_file(file, data, action);
+
+    TRACE_END();
+}
+
+static void content_start_job(content_job_t& job, content_type_t type, void* data, file_decode_func* decode)
+{
+    assert(!job.thread.joinable());
+
+    job.collected = false;
+    job.cancelled = false;
+    job.applied   = 0;
+    job.data      = data;
+
+    job.files.clear();
+
+    auto collect = [&job, type]() {
+        content_collect_files(type, job.files);
+
+        job.decoded.reset(new std::atomic<bool>[job.files.size()]());
+        job.collected.store(true, std::memory_order_release);
+    };
+
+#ifdef __EMSCRIPTEN__
+    // without threads files are decoded one
+    // by one as the main thread polls the job
+    collect();
+#else
+    job.thread = std::thread([&job, collect, decode]() {
+        collect();
+        content_decode_files(job.files, decode, job.decoded.get(), &job.cancelled);
+    });
+#endif
+}
 
-        free((char*)filename);
-        free((char*)file_extension);
+static bool content_poll_job(content_job_t& job, double budget, float* progress, file_decode_func* decode, file_action_func action)
+{
+    *progress = 0.0f;
+
+    if (!job.collected.load(std::memory_order_acquire)) return false;
+
+    uint64_t start     = platform_get_ticks();
+    double   frequency = 1.0 / (double)platform_get_ticks_frequency();
+
+    // decoded files are handed over in enumeration
+    // order until the frame's budget runs out
+    while (job.applied < job.files.size())
+    {
+        content_file_t& file = job.files[job.applied];
+
+#ifdef __EMSCRIPTEN__
+        if (decode) file.decoded = decode(file);
+#else
+        if (!job.decoded[job.applied].load(std::memory_order_acquire)) break;
+#endif
+
+        content_apply_file(file, job.data, action);
+
+        ++job.applied;
+
+        if ((platform_get_ticks() - start) * frequency > budget) break;
     }
 
-    filesystem_free_file_list(dir_files, dir_len);
+    *progress = job.files.empty() ? 1.0f : job.applied / (float)job.files.size();
+
+    if (job.applied < job.files.size()) return false;
+
+    if (job.thread.joinable()) job.thread.join();
+
+    return true;
 }
 
-static void asset_load_shaders(const char* filename, const char* filepath, void* data)
+// files already handed over stay loaded and are unloaded
+// with the rest of their type, the others are dropped here
+static void content_cancel_job(content_job_t& job, file_discard_func* discard)
 {
-    shader_t* shader = shader_new(filepath);
+    job.cancelled.store(true, std::memory_order_release);
+
+    if (job.thread.joinable()) job.thread.join();
+
+    if (!job.collected.load(std::memory_order_acquire)) return;
 
-    shaders.insert({std::string(filename), shader});
+    for (size_t i = job.applied; i < job.files.size(); ++i)
+    {
+        content_file_t& file = job.files[i];
+
+        if (discard && file.decoded) discard(file.decoded);
+        if (file.contents) pack_release(content_pack, file.entry, file.contents);
+    }
+
+    job.files.clear();
+    job.decoded.reset();
+
+    job.applied = 0;
+    job.collected.store(false, std::memory_order_release);
 }
 
-static void asset_load_textures(const char* filename, const char* filepath, void* data)
+// shader includes resolve against the shaders
+// directory, or the same folder inside the pack
+static char* content_include_shader(const char* name, size_t* size, void* data)
+{
+    std::string relative = std::string(content_type_paths[CONTENT_TYPE_shaders]) + "/" + name;
+
+    if (!content_pack) return filesystem_read_file((content_root + "/" + relative).c_str(), size);
+
+    size_t index;
+
+    if (!pack_find(content_pack, relative.c_str(), &index)) return NULL;
+
+    const void* contents = pack_read(content_pack, index, size);
+    char*       buffer   = contents ? (char*)malloc(*size + 1) : NULL;
+
+    if (buffer)
+    {
+        memcpy(buffer, contents, *size);
+        buffer[*size] = '\0';
+    }
+
+    if (contents) pack_release(content_pack, index, contents);
+
+    return buffer;
+}
+
+// every variant listed in the source is built next
+// to the base program and named "<file>_<variant>"
+static bool content_build_shaders(const content_file_t& file, const char* source, size_t size, bool (*build)(const char* name, shader_desc_t desc))
+{
+    char variants[SHADER_MAX_VARIANTS][SHADER_MAX_VARIANT_NAME];
+
+    size_t variants_len = shader_get_variants(source, size, variants);
+
+    shader_desc_t desc = {source, size, NULL, content_include_shader, NULL};
+
+    bool built = build(file.filename, desc);
+
+    for (size_t i = 0; i < variants_len; ++i)
+    {
+        desc.variant = variants[i];
+
+        built = build((std::string(file.filename) + "_" + variants[i]).c_str(), desc) && built;
+    }
+
+    return built;
+}
+
+static void asset_load_shaders(const content_file_t& file, void* data)
+{
+    size_t size   = file.size;
+    char*  source = file.contents ? NULL : filesystem_read_file(file.filepath, &size);
+
+    assert(file.contents || source);
+
+    content_build_shaders(file, file.contents ? (const char*)file.contents : source, size, [](const char* name, shader_desc_t desc) {
+        shader_t* shader = shader_submit(desc);
+
+        assert(shader);
+
+        asset_insert_shaders(name, shader);
+        content_pending_shaders.push_back(shader);
+
+        return true;
+    });
+
+    free(source);
+}
+
+bool content_finish_shaders(void)
+{
+    TRACE_BEGIN("content_finish_shaders");
+
+    // only programs the driver is done with are finished,
+    // the rest stay pending so no frame blocks on them
+    size_t pending = 0;
+
+    for (shader_t* shader : content_pending_shaders)
+    {
+        if (!shader_ready(shader))
+        {
+            content_pending_shaders[pending++] = shader;
+            continue;
+        }
+
+        bool finished = shader_finish(shader);
+
+        assert(finished);
+        (void)finished;
+    }
+
+    content_pending_shaders.resize(pending);
+
+    TRACE_END();
+
+    return pending == 0;
+}
+
+static void asset_load_textures(const content_file_t& file, void* data)
 {
     atlas_t* atlas = (atlas_t*)data;
 
-    texture_t* texture = texture_new_from_file(filepath);
+    content_image_t* image = (content_image_t*)file.decoded;
+
+    if (!image)
+    {
+        content_report_failed(file.filepath);
+        return;
+    }
 
-    int(*src)[4] = atlas_add_texture(atlas, texture->pixels, texture->width, texture->height);
+    atlas_sprite_t* sprite = atlas_add_texture(atlas, image->texture.pixels, image->texture.width, image->texture.height);
 
-    textures.insert({std::string(filename), src});
+    asset_insert_textures(file.filename, sprite);
 
-    texture_delete_stb(texture);
+    content_free_image(image);
 }
 
-static void asset_load_sounds(const char* filename, const char* filepath, void* data)
+static void asset_load_sounds(const content_file_t& file, void* data)
 {
-    sound_t* sound = sound_new(filepath);
+    sound_t* sound = (sound_t*)file.decoded;
+
+    if (!sound)
+    {
+        content_report_failed(file.filepath);
+        return;
+    }
 
-    sounds.insert({std::string(filename), sound});
+    asset_insert_sounds(file.filename, sound);
 }
 
 static void asset_unload_shaders(shader_t*& shader) { shader_delete(shader); }
 
-static void asset_unload_textures(texture_src_t*& texture) {}
+static void asset_unload_textures(atlas_sprite_t*& texture) {}
 
 static void asset_unload_sounds(sound_t*& sound) { sound_delete(sound); }
+
+static bool asset_reload_shaders(shader_t*& shader, const content_file_t& file, void* data)
+{
+    size_t size;
+    char*  source = filesystem_read_file(file.filepath, &size);
+
+    if (!source) return false;
+
+    // a variant that fails to compile keeps its old
+    // program, the others are still swapped in
+    bool reloaded = content_build_shaders(file, source, size, [](const char* name, shader_desc_t desc) {
+        auto it = shaders_ids.find(name);
+
+        return it != shaders_ids.end() && shader_reload(shaders[it->second], desc);
+    });
+
+    free(source);
+
+    return reloaded;
+}
+
+static bool asset_reload_textures(atlas_sprite_t*& texture, const content_file_t& file, void* data)
+{
+    atlas_t* atlas = (atlas_t*)data;
+
+    texture_t* decoded = texture_new_from_file(file.filepath);
+
+    bool replaced = decoded->pixels && atlas_replace_texture(atlas, &texture, decoded->pixels, decoded->width, decoded->height);
+
+    texture_delete_stb(decoded);
+    free(decoded);
+
+    return replaced;
+}
+
+// sounds may be playing, they're left alone
+static bool asset_reload_sounds(sound_t*& sound, const content_file_t& file, void* data) { return false; }
@@ -15,30 +15,61 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#define CONTENT_ID_NONE (UINT32_MAX)
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
-    typedef struct shader_t shader_t;
-    typedef struct sound_t  sound_t;
-    typedef int             texture_src_t[4];
+    typedef struct shader_t       shader_t;
+    typedef struct sound_t        sound_t;
+    typedef struct atlas_sprite_t atlas_sprite_t;
 
-#define CONTENT_DECLARE(type, name)            \
-    void content_load_##name(void);            \
-    void content_load_##name##_ex(void* data); \
-    void content_unload_##name(void);          \
-    bool content_find_##name(const char* filename, type* asset);
+    // async loads decode on worker threads, polling hands
+    // results over within a budget given in seconds, cancel
+    // stops the workers and frees what wasn't handed over
+#define CONTENT_DECLARE(type, name)                                  \
+    void     content_load_##name(void);                              \
+    void     content_load_##name##_ex(void* data);                   \
+    void     content_load_##name##_async(void* data);                \
+    bool     content_poll_##name(double budget, float* progress);    \
+    void     content_cancel_##name(void);                            \
+    void     content_unload_##name(void);                            \
+    bool     content_find_##name(const char* filename, type* asset); \
+    uint32_t content_id_##name(const char* filename);                \
+    type     content_get_##name(uint32_t id);
 
 #define CONTENT_TYPES                           \
     X(shader_t*, ".shader", "shaders", shaders) \
     X(sound_t*, ".wav", "sounds", sounds)       \
-    X(texture_src_t*, ".png|.jpg|.jpeg", "textures", textures)
+    X(atlas_sprite_t*, ".png|.jpg|.jpeg", "textures", textures)
 
 #define X(type, extension, path, name) CONTENT_DECLARE(type, name)
     CONTENT_TYPES
 #undef X
 
+    // indexes assets.pack next to the executable, or the assets
+    // directory without one, returns whether the pack was found
+    bool content_mount(void);
+    void content_unmount(void);
+
+    // loaded shaders are only submitted to the driver, this finishes
+    // the ones it has compiled and returns whether all of them are,
+    // none may be used before then
+    bool content_finish_shaders(void);
+
+    // changed shaders and textures under assets are
+    // reloaded in place, data is the live atlas
+    void content_watch_start(void);
+    void content_watch_stop(void);
+    void content_watch_update(void* data);
+
+    // lookups by name between begin and end
+    // are reported in debug builds
+    void content_begin_frame(void);
+    void content_end_frame(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,10 +8,20 @@
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
 // platform/filesystem.c
 
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <filesystem>
+#include <string>
+#include <system_error>
+#include <unordered_map>
 #include <vector>
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 #include "platform/filesystem.h"
 
 char* filesystem_get_file_name(const char* path, bool with_extension)
@@ -35,6 +45,49 @@ char* filesystem_get_file_extension(const char* path)
     return buffer;
 }
 
+bool filesystem_get_file_stat(const char* path, uint64_t* size, uint64_t* mtime)
+{
+    std::error_code error;
+
+    auto file_size = std::filesystem::file_size(path, error);
+    if (error) return false;
+
+    auto file_time = std::filesystem::last_write_time(path, error);
+    if (error) return false;
+
+    *size  = (uint64_t)file_size;
+    *mtime = (uint64_t)file_time.time_since_epoch().count();
+
+    return true;
+}
+
+char* filesystem_read_file(const char* path, size_t* size)
+{
+    FILE* file = fopen(path, "rb");
+
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+
+    *size        = (size_t)ftell(file);
+    char* buffer = (char*)malloc(*size + 1);
+
+    fseek(file, 0, SEEK_SET);
+
+    if (buffer == NULL || fread(buffer, 1, *size, file) != *size)
+    {
+        free(buffer);
+        fclose(file);
+        return NULL;
+    }
+
+    fclose(file);
+
+    buffer[*size] = '\0';
+
+    return buffer;
+}
+
 void filesystem_enumerate_dir(const char* path, const char*** list, size_t* len, bool recursive)
 {
     if (std::filesystem::is_directory(std::filesystem::status(path)))
@@ -70,3 +123,115 @@ void filesystem_free_file_list(const char** list, size_t len)
 
     delete[] list;
 }
+
+void filesystem_walk_dir(const char* path, void (*callback)(const char* filepath, void* data), void* data)
+{
+    if (!std::filesystem::is_directory(std::filesystem::status(path))) return;
+
+    for (auto& p : std::filesystem::recursive_directory_iterator(path))
+        if (p.is_regular_file()) callback(p.path().string().c_str(), data);
+}
+
+struct filesystem_watch_t
+{
+#ifdef __linux__
+    int fd;
+
+    std::unordered_map<int, std::string> dirs;
+    std::string                          filepath;
+
+    alignas(inotify_event) char buffer[4096];
+
+    ssize_t len;
+    ssize_t offset;
+#endif
+};
+
+#ifdef __linux__
+static void filesystem_watch_add(filesystem_watch_t* watch, const std::string& path)
+{
+    int wd = inotify_add_watch(watch->fd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+    if (wd >= 0) watch->dirs[wd] = path;
+}
+#endif
+
+filesystem_watch_t* filesystem_watch_new(const char* path)
+{
+#ifdef __linux__
+    if (!std::filesystem::is_directory(std::filesystem::status(path))) return NULL;
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (fd < 0) return NULL;
+
+    filesystem_watch_t* watch = new filesystem_watch_t();
+
+    watch->fd     = fd;
+    watch->len    = 0;
+    watch->offset = 0;
+
+    // inotify isn't recursive, every directory gets its own watch
+    filesystem_watch_add(watch, path);
+
+    for (auto& p : std::filesystem::recursive_directory_iterator(path))
+        if (p.is_directory()) filesystem_watch_add(watch, p.path().string());
+
+    return watch;
+#else
+    return NULL;
+#endif
+}
+
+void filesystem_watch_delete(filesystem_watch_t* watch)
+{
+    if (!watch) return;
+
+#ifdef __linux__
+    close(watch->fd);
+#endif
+    delete watch;
+}
+
+bool filesystem_watch_poll(filesystem_watch_t* watch, const char** filepath)
+{
+#ifdef __linux__
+    while (true)
+    {
+        if (watch->offset >= watch->len)
+        {
+            watch->len    = read(watch->fd, watch->buffer, sizeof(watch->buffer));
+            watch->offset = 0;
+
+            if (watch->len <= 0) return false;
+        }
+
+        const inotify_event* event = (const inotify_event*)(watch->buffer + watch->offset);
+
+        watch->offset += sizeof(inotify_event) + event->len;
+
+        auto dir = watch->dirs.find(event->wd);
+
+        if (event->len == 0 || dir == watch->dirs.end()) continue;
+
+        std::string path = dir->second + "/" + event->name;
+
+        if (event->mask & IN_ISDIR)
+        {
+            if (event->mask & IN_CREATE) filesystem_watch_add(watch, path);
+            continue;
+        }
+
+        // creation alone isn't a change, the write
+        // that follows reports the file once it's done
+        if (event->mask & IN_CREATE) continue;
+
+        watch->filepath = path;
+        *filepath       = watch->filepath.c_str();
+
+        return true;
+    }
+#else
+    return false;
+#endif
+}
@@ -13,6 +13,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -21,9 +22,23 @@ extern "C"
 
     char* filesystem_get_file_name(const char* path, bool with_extension);
     char* filesystem_get_file_extension(const char* path);
+    bool  filesystem_get_file_stat(const char* path, uint64_t* size, uint64_t* mtime);
+
+    // the whole file with a terminator past size, NULL when
+    // it can't be read, the buffer is released with free
+    char* filesystem_read_file(const char* path, size_t* size);
 
     void filesystem_enumerate_dir(const char* path, const char*** list, size_t* len, bool recursive);
     void filesystem_free_file_list(const char** list, size_t len);
+    void filesystem_walk_dir(const char* path, void (*callback)(const char* filepath, void* data), void* data);
+
+    typedef struct filesystem_watch_t filesystem_watch_t;
+
+    // only implemented with inotify on linux, elsewhere
+    // no watch is created and nothing is ever reported
+    filesystem_watch_t* filesystem_watch_new(const char* path);
+    void                filesystem_watch_delete(filesystem_watch_t* watch);
+    bool                filesystem_watch_poll(filesystem_watch_t* watch, const char** filepath);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,305 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______   ______   ______   __  __     //
+//  /\  == \ /\  __ \ /\  ___\ /\ \/ /     //
+//  \ \  _-/ \ \  __ \\ \ \____\ \  _"-.   //
+//   \ \_\    \ \_\ \_\\ \_____\\ \_\ \_\  //
+//    \/_/     \/_/\/_/ \/_____/ \/_/\/_/  //
+//                                         //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// platform/pack.cc
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "platform/pack.h"
+
+struct pack_t
+{
+    const uint8_t*      data;
+    size_t              size;
+    const pack_entry_t* entries;
+    const char*         names;
+    uint32_t            entries_len;
+
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+static bool pack_map(pack_t* pack, const char* filepath)
+{
+#ifdef _WIN32
+    pack->file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (pack->file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+
+    GetFileSizeEx(pack->file, &size);
+
+    pack->size    = (size_t)size.QuadPart;
+    pack->mapping = CreateFileMappingA(pack->file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (pack->mapping == NULL)
+    {
+        CloseHandle(pack->file);
+        return false;
+    }
+
+    pack->data = (const uint8_t*)MapViewOfFile(pack->mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (pack->data == NULL)
+    {
+        CloseHandle(pack->mapping);
+        CloseHandle(pack->file);
+        return false;
+    }
+#else
+    int file = open(filepath, O_RDONLY);
+
+    if (file < 0) return false;
+
+    struct stat status;
+
+    if (fstat(file, &status) != 0 || status.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+
+    void* data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+    // the mapping stays valid after
+    // the descriptor is closed
+    close(file);
+
+    if (data == MAP_FAILED) return false;
+
+    pack->data = (const uint8_t*)data;
+    pack->size = (size_t)status.st_size;
+#endif
+
+    return true;
+}
+
+static void pack_unmap(pack_t* pack)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(pack->data);
+    CloseHandle(pack->mapping);
+    CloseHandle(pack->file);
+#else
+    munmap((void*)pack->data, pack->size);
+#endif
+}
+
+// every entry is checked once here so reads can trust them,
+// the names block has to end in a terminator for lookups
+static bool pack_check_entries(const pack_t* pack, uint32_t names_size)
+{
+    if (pack->entries_len > 0 && (names_size == 0 || pack->names[names_size - 1] != '\0')) return false;
+
+    for (uint32_t i = 0; i < pack->entries_len; ++i)
+    {
+        const pack_entry_t* entry = &pack->entries[i];
+
+        if (entry->name >= names_size) return false;
+        if (entry->packed_size > entry->size) return false;
+        if ((uint64_t)entry->offset + entry->packed_size > pack->size) return false;
+    }
+
+    return true;
+}
+
+pack_t* pack_open(const char* filepath)
+{
+    pack_t* pack = (pack_t*)malloc(sizeof(pack_t));
+
+    if (pack == NULL) return NULL;
+
+    if (!pack_map(pack, filepath))
+    {
+        free(pack);
+        return NULL;
+    }
+
+    const pack_header_t* header = (const pack_header_t*)pack->data;
+
+    bool is_valid = pack->size >= sizeof(pack_header_t) && header->magic == PACK_MAGIC && header->version == PACK_VERSION;
+
+    is_valid = is_valid && pack->size >= sizeof(pack_header_t) + (uint64_t)header->entries_len * sizeof(pack_entry_t) + header->names_size;
+
+    if (is_valid)
+    {
+        pack->entries_len = header->entries_len;
+        pack->entries     = (const pack_entry_t*)(pack->data + sizeof(pack_header_t));
+        pack->names       = (const char*)(pack->entries + pack->entries_len);
+
+        is_valid = pack_check_entries(pack, header->names_size);
+    }
+
+    if (!is_valid)
+    {
+#ifdef DEBUG
+        printf("   - Invalid pack \"%s\"\n", filepath);
+#endif
+        pack_unmap(pack);
+        free(pack);
+        return NULL;
+    }
+
+    return pack;
+}
+
+void pack_close(pack_t* pack)
+{
+    pack_unmap(pack);
+    free(pack);
+}
+
+size_t pack_get_len(pack_t* pack) { return pack->entries_len; }
+
+const char* pack_get_name(pack_t* pack, size_t index) { return pack->names + pack->entries[index].name; }
+
+bool pack_find(pack_t* pack, const char* name, size_t* index)
+{
+    size_t low  = 0;
+    size_t high = pack->entries_len;
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        int    order  = strcmp(pack->names + pack->entries[middle].name, name);
+
+        if (order == 0)
+        {
+            *index = middle;
+            return true;
+        }
+
+        if (order < 0) low = middle + 1;
+        else high = middle;
+    }
+
+    return false;
+}
+
+const void* pack_read(pack_t* pack, size_t index, size_t* size)
+{
+    const pack_entry_t* entry = &pack->entries[index];
+    const uint8_t*      data  = pack->data + entry->offset;
+
+    *size = entry->size;
+
+    if (entry->packed_size == entry->size) return data;
+
+    uint8_t* buffer = (uint8_t*)malloc(entry->size);
+
+    if (buffer == NULL || !pack_lz4_decompress(data, entry->packed_size, buffer, entry->size))
+    {
+        free(buffer);
+        return NULL;
+    }
+
+    return buffer;
+}
+
+void pack_release(pack_t* pack, size_t index, const void* data)
+{
+    const pack_entry_t* entry = &pack->entries[index];
+
+    if (entry->packed_size != entry->size) free((void*)data);
+}
+
+bool pack_is_stored(pack_t* pack, size_t index)
+{
+    const pack_entry_t* entry = &pack->entries[index];
+
+    return entry->packed_size == entry->size;
+}
+
+bool pack_lz4_decompress(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len)
+{
+    const uint8_t* src_end   = src + src_len;
+    uint8_t*       dst_start = dst;
+    uint8_t*       dst_end   = dst + dst_len;
+
+    while (src < src_end)
+    {
+        uint8_t token = *src++;
+
+        // high nibble is the literal length, lengths
+        // of 15 continue in bytes until one isn't 255
+        size_t literals = token >> 4;
+
+        if (literals == 15)
+        {
+            uint8_t extra;
+
+            do
+            {
+                if (src == src_end) return false;
+
+                extra = *src++;
+                literals += extra;
+            } while (extra == 255);
+        }
+
+        if (literals > (size_t)(src_end - src) || literals > (size_t)(dst_end - dst)) return false;
+
+        memcpy(dst, src, literals);
+
+        src += literals;
+        dst += literals;
+
+        // the last sequence ends after its literals
+        if (src == src_end) break;
+
+        if (src_end - src < 2) return false;
+
+        size_t offset = src[0] | (src[1] << 8);
+
+        src += 2;
+
+        if (offset == 0 || offset > (size_t)(dst - dst_start)) return false;
+
+        size_t match = token & 15;
+
+        if (match == 15)
+        {
+            uint8_t extra;
+
+            do
+            {
+                if (src == src_end) return false;
+
+                extra = *src++;
+                match += extra;
+            } while (extra == 255);
+        }
+
+        match += 4;
+
+        if (match > (size_t)(dst_end - dst)) return false;
+
+        // matches may overlap the bytes they produce
+        const uint8_t* from = dst - offset;
+
+        for (size_t i = 0; i < match; ++i) dst[i] = from[i];
+
+        dst += match;
+    }
+
+    return dst == dst_end;
+}
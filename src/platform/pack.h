@@ -0,0 +1,68 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______   ______   ______   __  __     //
+//  /\  == \ /\  __ \ /\  ___\ /\ \/ /     //
+//  \ \  _-/ \ \  __ \\ \ \____\ \  _"-.   //
+//   \ \_\    \ \_\ \_\\ \_____\\ \_\ \_\  //
+//    \/_/     \/_/\/_/ \/_____/ \/_/\/_/  //
+//                                         //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// platform/pack.h
+
+#ifndef PLATFORM_PACK_H
+#define PLATFORM_PACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PACK_MAGIC     (0x4B434150u)  // "PACK"
+#define PACK_VERSION   (1u)
+#define PACK_ALIGNMENT (16u)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct pack_t pack_t;
+
+    // file layout: header, entries sorted by name,
+    // names, then every entry's data aligned
+    typedef struct pack_header_t
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entries_len;
+        uint32_t names_size;
+    } pack_header_t;
+
+    typedef struct pack_entry_t
+    {
+        uint32_t name;         // offset into the names block
+        uint32_t offset;       // offset from the start of the file
+        uint32_t size;         // size once unpacked
+        uint32_t packed_size;  // smaller than size when lz4 compressed
+    } pack_entry_t;
+
+    pack_t* pack_open(const char* filepath);
+    void    pack_close(pack_t* pack);
+
+    size_t      pack_get_len(pack_t* pack);
+    const char* pack_get_name(pack_t* pack, size_t index);
+    bool        pack_find(pack_t* pack, const char* name, size_t* index);
+
+    // stored entries point straight into the mapping,
+    // compressed ones are unpacked until released
+    const void* pack_read(pack_t* pack, size_t index, size_t* size);
+    void        pack_release(pack_t* pack, size_t index, const void* data);
+
+    // stored entries stay readable until the pack is closed
+    bool pack_is_stored(pack_t* pack, size_t index);
+
+    bool pack_lz4_decompress(const uint8_t* src, size_t src_len, uint8_t* dst, size_t dst_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // PLATFORM_PACK_H
@@ -0,0 +1,129 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______  ______   ______   ______   ______     //
+//  /\__  _\/\  == \ /\  __ \ /\  ___\ /\  ___\    //
+//  \/_/\ \/\ \  __< \ \  __ \\ \ \____\ \  __\    //
+//     \ \_\ \ \_\ \_\\ \_\ \_\\ \_____\\ \_____\  //
+//      \/_/  \/_/ /_/ \/_/\/_/ \/_____/ \/_____/  //
+//                                                 //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// platform/trace.cc
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "platform/trace.h"
+#include "platform/platform.h"
+
+#ifdef DEBUG
+struct trace_event_t
+{
+    uint64_t ticks;
+    uint32_t thread;
+    char     phase;
+    char     name[TRACE_NAME_LEN];
+};
+
+static trace_event_t*        trace_events;
+static std::atomic<size_t>   trace_len;
+static std::atomic<uint32_t> trace_threads;
+static std::string           trace_filepath;
+static uint64_t              trace_start;
+
+// threads are numbered in the order
+// they record their first event
+static uint32_t trace_get_thread(void)
+{
+    static thread_local uint32_t thread = trace_threads.fetch_add(1, std::memory_order_relaxed);
+
+    return thread;
+}
+
+static void trace_push(char phase, const char* name)
+{
+    if (!trace_events) return;
+
+    size_t index = trace_len.fetch_add(1, std::memory_order_relaxed);
+
+    if (index >= TRACE_MAX_EVENTS) return;
+
+    trace_event_t* event = &trace_events[index];
+
+    event->ticks  = platform_get_ticks();
+    event->thread = trace_get_thread();
+    event->phase  = phase;
+
+    snprintf(event->name, TRACE_NAME_LEN, "%s", name);
+}
+
+static void trace_write_name(FILE* file, const char* name)
+{
+    for (const char* c = name; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\') fputc('\\', file);
+        fputc(*c, file);
+    }
+}
+
+void trace_init(void)
+{
+    const char* filepath = getenv("GAME_TRACE");
+
+    if (!filepath || !*filepath) return;
+
+    trace_events   = (trace_event_t*)calloc(TRACE_MAX_EVENTS, sizeof(trace_event_t));
+    trace_filepath = filepath;
+    trace_start    = platform_get_ticks();
+
+    // the main thread records first and is always
+    // thread 0, workers follow as they start
+    trace_get_thread();
+}
+
+void trace_shutdown(void)
+{
+    if (!trace_events) return;
+
+    FILE* file = fopen(trace_filepath.c_str(), "w");
+
+    if (file)
+    {
+        size_t len   = trace_len.load() < TRACE_MAX_EVENTS ? trace_len.load() : TRACE_MAX_EVENTS;
+        double scale = 1000000.0 / (double)platform_get_ticks_frequency();
+
+        fprintf(file, "{\"traceEvents\":[\n");
+
+        for (size_t i = 0; i < len; ++i)
+        {
+            const trace_event_t* event = &trace_events[i];
+
+            fprintf(file, "{\"name\":\"");
+            trace_write_name(file, event->name);
+            fprintf(file, "\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%u}%s\n", event->phase, (event->ticks - trace_start) * scale, event->thread, i + 1 < len ? "," : "");
+        }
+
+        fprintf(file, "]}\n");
+        fclose(file);
+
+        printf("   - Wrote %zu trace events to \"%s\"\n", len, trace_filepath.c_str());
+    }
+
+    free(trace_events);
+
+    trace_events = NULL;
+}
+
+void trace_begin(const char* name) { trace_push('B', name); }
+
+void trace_end(void) { trace_push('E', ""); }
+#else
+void trace_init(void) {}
+
+void trace_shutdown(void) {}
+
+void trace_begin(const char* name) {}
+
+void trace_end(void) {}
+#endif
@@ -0,0 +1,44 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______  ______   ______   ______   ______     //
+//  /\__  _\/\  == \ /\  __ \ /\  ___\ /\  ___\    //
+//  \/_/\ \/\ \  __< \ \  __ \\ \ \____\ \  __\    //
+//     \ \_\ \ \_\ \_\\ \_\ \_\\ \_____\\ \_____\  //
+//      \/_/  \/_/ /_/ \/_/\/_/ \/_____/ \/_____/  //
+//                                                 //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// platform/trace.h
+
+#ifndef PLATFORM_TRACE_H
+#define PLATFORM_TRACE_H
+
+#define TRACE_MAX_EVENTS (1 << 16)
+#define TRACE_NAME_LEN   (48)
+
+// markers only exist in debug builds, release
+// builds compile every scope down to nothing
+#ifdef DEBUG
+#define TRACE_BEGIN(name) trace_begin(name)
+#define TRACE_END()       trace_end()
+#else
+#define TRACE_BEGIN(name)
+#define TRACE_END()
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    // recording starts when GAME_TRACE names an output
+    // file, chrome://tracing or perfetto can open it
+    void trace_init(void);
+    void trace_shutdown(void);
+
+    void trace_begin(const char* name);
+    void trace_end(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // PLATFORM_TRACE_H
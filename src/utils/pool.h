@@ -12,9 +12,22 @@
 #define UTILS_POOL_H
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+// items start on a cache line, so a pool
+// of small structs doesn't straddle one more
+#define POOL_ALIGNMENT (64)
+
+// a handle is a slot in the low bits and the slot's generation
+// above it, a million slots and four thousand reuses of each
+// before an old handle could be mistaken for a new one
+#define POOL_HANDLE_SLOT_BITS (20)
+#define POOL_HANDLE_NONE      (0)
+#define POOL_SLOT_NONE        (UINT32_MAX)
 
 #ifdef __cplusplus
 extern "C"
@@ -29,113 +42,294 @@ extern "C"
         POOL_FLAGS_RECYCLE = 1 << 2,
     };
 
-#define POOL_DECLARE(type, name)                             \
-    void   name##_pool_new(size_t capacity, uint32_t flags); \
-    void   name##_pool_delete(void);                         \
-    void   name##_pool_reserve(size_t capacity);             \
-    void   name##_pool_insert(type item);                    \
-    void   name##_pool_remove(uint32_t index);               \
-    type*  name##_pool_begin(void);                          \
-    type*  name##_pool_end(void);                            \
-    size_t name##_pool_count(void);
-
-#define POOL_DEFINE(type, name)                                                                                 \
-    static struct                                                                                               \
-    {                                                                                                           \
-        uint32_t flags;                                                                                         \
-                                                                                                                \
-        type* data;                                                                                             \
-                                                                                                                \
-        size_t start;                                                                                           \
-        size_t count;                                                                                           \
-        size_t capacity;                                                                                        \
-    } name##_pool;                                                                                              \
-                                                                                                                \
-    void name##_pool_new(size_t capacity, uint32_t flags)                                                       \
-    {                                                                                                           \
-        assert(capacity > 0);                                                                                   \
-        assert((flags & (POOL_FLAGS_EXPAND | POOL_FLAGS_RECYCLE)) != (POOL_FLAGS_EXPAND | POOL_FLAGS_RECYCLE)); \
-                                                                                                                \
-        name##_pool.data     = (type*)malloc(capacity * sizeof(type));                                          \
-        name##_pool.start    = 0;                                                                               \
-        name##_pool.count    = 0;                                                                               \
-        name##_pool.capacity = capacity;                                                                        \
-        name##_pool.flags    = flags;                                                                           \
-                                                                                                                \
-        assert(name##_pool.data != NULL);                                                                       \
-    }                                                                                                           \
-                                                                                                                \
-    void name##_pool_delete(void)                                                                               \
-    {                                                                                                           \
-        free(name##_pool.data);                                                                                 \
-                                                                                                                \
-        name##_pool.start    = 0;                                                                               \
-        name##_pool.count    = 0;                                                                               \
-        name##_pool.capacity = 0;                                                                               \
-    }                                                                                                           \
-                                                                                                                \
-    void name##_pool_reserve(size_t capacity)                                                                   \
-    {                                                                                                           \
-        type* prev = name##_pool.data;                                                                          \
-        type* curr = (type*)malloc(capacity * sizeof(type));                                                    \
-                                                                                                                \
-        assert(curr != NULL);                                                                                   \
-                                                                                                                \
-        for (size_t i = 0; i < name##_pool.count; ++i)                                                          \
-        {                                                                                                       \
-            curr[i] = prev[(name##_pool.start + i) % name##_pool.capacity];                                     \
-        }                                                                                                       \
-                                                                                                                \
-        name##_pool.data     = curr;                                                                            \
-        name##_pool.start    = 0;                                                                               \
-        name##_pool.capacity = capacity;                                                                        \
-                                                                                                                \
-        free(prev);                                                                                             \
-    }                                                                                                           \
-                                                                                                                \
-    void name##_pool_insert(type item)                                                                          \
-    {                                                                                                           \
-        if ((name##_pool.flags & POOL_FLAGS_ASSERT) == POOL_FLAGS_ASSERT)                                       \
-        {                                                                                                       \
-            assert(name##_pool.count + 1 <= name##_pool.capacity);                                              \
-        }                                                                                                       \
-                                                                                                                \
-        if (name##_pool.count >= name##_pool.capacity)                                                          \
-        {                                                                                                       \
-            if ((name##_pool.flags & POOL_FLAGS_EXPAND) == POOL_FLAGS_EXPAND)                                   \
-            {                                                                                                   \
-                name##_pool_reserve(name##_pool.capacity * 2);                                                  \
-                name##_pool_insert(item);                                                                       \
-            }                                                                                                   \
-                                                                                                                \
-            if ((name##_pool.flags & POOL_FLAGS_RECYCLE) == POOL_FLAGS_RECYCLE)                                 \
-            {                                                                                                   \
-                name##_pool.data[name##_pool.start] = item;                                                     \
-                name##_pool.start                   = (name##_pool.start + 1) % name##_pool.count;              \
-            }                                                                                                   \
-                                                                                                                \
-            return;                                                                                             \
-        }                                                                                                       \
-                                                                                                                \
-        name##_pool.data[name##_pool.count++] = item;                                                           \
-    }                                                                                                           \
-                                                                                                                \
-    void name##_pool_remove(uint32_t index)                                                                     \
-    {                                                                                                           \
-        assert(name##_pool.count > 0);                                                                          \
-                                                                                                                \
-        name##_pool.data[index] = name##_pool.data[name##_pool.count - 1];                                      \
-        --name##_pool.count;                                                                                    \
-    }                                                                                                           \
-                                                                                                                \
-    type* name##_pool_begin(void) { return &name##_pool.data[0]; }                                              \
-                                                                                                                \
-    type* name##_pool_end(void) { return &name##_pool.data[name##_pool.count]; }                                \
-                                                                                                                \
-    size_t name##_pool_count(void) { return name##_pool.count; }
-
-#define POOL_LOOP_FORWARD(type, name, var) for (type* var = name##_pool_begin(); var != name##_pool_end(); ++var)
-#define POOL_LOOP_REVERSE(type, name, var) for (type* var = name##_pool_end() - 1; var >= name##_pool_begin(); --var)
+    // realloc keeps growing in place where it can, the slack
+    // lets the data be aligned wherever the block lands and
+    // moves it back onto the line if the offset changed
+    static inline void* pool_realloc(void** block, void* data, size_t used, size_t size)
+    {
+        size_t offset = data ? (size_t)((char*)data - (char*)*block) : 0;
+        char*  raw    = (char*)realloc(*block, size + POOL_ALIGNMENT - 1);
+
+        assert(raw != NULL);
+
+        char* aligned = (char*)(((uintptr_t)raw + POOL_ALIGNMENT - 1) & ~(uintptr_t)(POOL_ALIGNMENT - 1));
+
+        if (aligned != raw + offset) memmove(aligned, raw + offset, used);
+
+        *block = raw;
+
+        return aligned;
+    }
+
+    typedef uint32_t pool_handle_t;
+
+    typedef struct pool_slot_t
+    {
+        uint32_t generation;
+        uint32_t index;  // into the data while live
+        uint32_t older;  // live slots are linked in the order they were inserted
+        uint32_t newer;
+    } pool_slot_t;
+
+    static inline pool_handle_t pool_handle_make(uint32_t slot, uint32_t generation) { return generation << POOL_HANDLE_SLOT_BITS | slot; }
+
+    static inline uint32_t pool_handle_slot(pool_handle_t handle) { return handle & ((1u << POOL_HANDLE_SLOT_BITS) - 1); }
+
+    static inline uint32_t pool_handle_generation(pool_handle_t handle) { return handle >> POOL_HANDLE_SLOT_BITS; }
+
+    // the handles past the count are the free slots, so insert
+    // takes the next one in line without chasing a free list,
+    // every generation starts at one so no handle is zero
+    static inline void pool_slots_grow(pool_slot_t** slots, pool_handle_t** handles, size_t from, size_t to)
+    {
+        assert(to <= (size_t)1 << POOL_HANDLE_SLOT_BITS);
+
+        *slots   = (pool_slot_t*)realloc(*slots, to * sizeof(pool_slot_t));
+        *handles = (pool_handle_t*)realloc(*handles, to * sizeof(pool_handle_t));
+
+        assert(*slots != NULL && *handles != NULL);
+
+        for (size_t i = from; i < to; ++i)
+        {
+            (*slots)[i].generation = 1;
+            (*handles)[i]          = pool_handle_make((uint32_t)i, 1);
+        }
+    }
+
+    // bumping the generation is what makes every handle to the
+    // slot stale, it wraps past zero, the result is the handle
+    // the slot is given out with next
+    static inline pool_handle_t pool_slot_release(pool_slot_t* slots, uint32_t slot)
+    {
+        uint32_t generation = (slots[slot].generation + 1) & (UINT32_MAX >> POOL_HANDLE_SLOT_BITS);
+
+        slots[slot].generation = generation ? generation : 1;
+
+        return pool_handle_make(slot, slots[slot].generation);
+    }
+
+    // the insertion order is what recycling goes by, swap
+    // removes shuffle the data so it can't be read from there
+    static inline void pool_order_link(pool_slot_t* slots, uint32_t* oldest, uint32_t* newest, uint32_t slot)
+    {
+        slots[slot].older = *newest;
+        slots[slot].newer = POOL_SLOT_NONE;
+
+        if (*newest != POOL_SLOT_NONE) slots[*newest].newer = slot;
+        else *oldest = slot;
+
+        *newest = slot;
+    }
+
+    static inline void pool_order_unlink(pool_slot_t* slots, uint32_t* oldest, uint32_t* newest, uint32_t slot)
+    {
+        uint32_t older = slots[slot].older;
+        uint32_t newer = slots[slot].newer;
+
+        if (older != POOL_SLOT_NONE) slots[older].newer = newer;
+        else *oldest = newer;
+
+        if (newer != POOL_SLOT_NONE) slots[newer].older = older;
+        else *newest = older;
+    }
+
+    // a pool is a value owned by whoever declares one, declare
+    // gives the struct and prototypes, define the functions
+    //
+    // items are packed for iteration and swap removed, so an
+    // index only holds until the next remove, a handle from
+    // insert holds until its own item goes, get returns NULL
+    // and remove_handle false for a stale one, at asserts it
+    // isn't, recycling pools evict the oldest item when full
+#define POOL_DECLARE(type, name)                                                         \
+    typedef struct name##_pool_t                                                         \
+    {                                                                                    \
+        uint32_t flags;                                                                  \
+                                                                                         \
+        void*          block;                                                            \
+        type*          data;                                                             \
+        pool_handle_t* handles;                                                          \
+        pool_slot_t*   slots;                                                            \
+                                                                                         \
+        uint32_t oldest;                                                                 \
+        uint32_t newest;                                                                 \
+        size_t   count;                                                                  \
+        size_t   capacity;                                                               \
+    } name##_pool_t;                                                                     \
+                                                                                         \
+    void          name##_pool_new(name##_pool_t* pool, size_t capacity, uint32_t flags); \
+    void          name##_pool_delete(name##_pool_t* pool);                               \
+    void          name##_pool_reserve(name##_pool_t* pool, size_t capacity);             \
+    void          name##_pool_clear(name##_pool_t* pool);                                \
+    pool_handle_t name##_pool_insert(name##_pool_t* pool, type item);                    \
+    void          name##_pool_remove(name##_pool_t* pool, uint32_t index);               \
+    bool          name##_pool_remove_handle(name##_pool_t* pool, pool_handle_t handle);  \
+    type*         name##_pool_get(name##_pool_t* pool, pool_handle_t handle);            \
+    type*         name##_pool_at(name##_pool_t* pool, pool_handle_t handle);             \
+    pool_handle_t name##_pool_handle(name##_pool_t* pool, uint32_t index);               \
+    type*         name##_pool_begin(name##_pool_t* pool);                                \
+    type*         name##_pool_end(name##_pool_t* pool);                                  \
+    size_t        name##_pool_count(name##_pool_t* pool);
+
+#define POOL_DEFINE(type, name)                                                                                          \
+    void name##_pool_new(name##_pool_t* pool, size_t capacity, uint32_t flags)                                           \
+    {                                                                                                                    \
+        assert(capacity > 0);                                                                                            \
+        assert((flags & (POOL_FLAGS_EXPAND | POOL_FLAGS_RECYCLE)) != (POOL_FLAGS_EXPAND | POOL_FLAGS_RECYCLE));          \
+                                                                                                                         \
+        pool->block    = NULL;                                                                                           \
+        pool->data     = (type*)pool_realloc(&pool->block, NULL, 0, capacity * sizeof(type));                            \
+        pool->handles  = NULL;                                                                                           \
+        pool->slots    = NULL;                                                                                           \
+        pool->oldest   = POOL_SLOT_NONE;                                                                                 \
+        pool->newest   = POOL_SLOT_NONE;                                                                                 \
+        pool->count    = 0;                                                                                              \
+        pool->capacity = capacity;                                                                                       \
+        pool->flags    = flags;                                                                                          \
+                                                                                                                         \
+        pool_slots_grow(&pool->slots, &pool->handles, 0, capacity);                                                      \
+    }                                                                                                                    \
+                                                                                                                         \
+    void name##_pool_delete(name##_pool_t* pool)                                                                         \
+    {                                                                                                                    \
+        free(pool->block);                                                                                               \
+        free(pool->handles);                                                                                             \
+        free(pool->slots);                                                                                               \
+                                                                                                                         \
+        pool->block    = NULL;                                                                                           \
+        pool->data     = NULL;                                                                                           \
+        pool->handles  = NULL;                                                                                           \
+        pool->slots    = NULL;                                                                                           \
+        pool->oldest   = POOL_SLOT_NONE;                                                                                 \
+        pool->newest   = POOL_SLOT_NONE;                                                                                 \
+        pool->count    = 0;                                                                                              \
+        pool->capacity = 0;                                                                                              \
+    }                                                                                                                    \
+                                                                                                                         \
+    void name##_pool_reserve(name##_pool_t* pool, size_t capacity)                                                       \
+    {                                                                                                                    \
+        if (capacity <= pool->capacity) return;                                                                          \
+                                                                                                                         \
+        pool->data = (type*)pool_realloc(&pool->block, pool->data, pool->count * sizeof(type), capacity * sizeof(type)); \
+                                                                                                                         \
+        pool_slots_grow(&pool->slots, &pool->handles, pool->capacity, capacity);                                         \
+                                                                                                                         \
+        pool->capacity = capacity;                                                                                       \
+    }                                                                                                                    \
+                                                                                                                         \
+    void name##_pool_clear(name##_pool_t* pool)                                                                          \
+    {                                                                                                                    \
+        for (size_t i = 0; i < pool->count; ++i)                                                                         \
+        {                                                                                                                \
+            pool->handles[i] = pool_slot_release(pool->slots, pool_handle_slot(pool->handles[i]));                       \
+        }                                                                                                                \
+                                                                                                                         \
+        pool->oldest = POOL_SLOT_NONE;                                                                                   \
+        pool->newest = POOL_SLOT_NONE;                                                                                   \
+        pool->count  = 0;                                                                                                \
+    }                                                                                                                    \
+                                                                                                                         \
+    pool_handle_t name##_pool_insert(name##_pool_t* pool, type item)                                                     \
+    {                                                                                                                    \
+        if ((pool->flags & POOL_FLAGS_ASSERT) == POOL_FLAGS_ASSERT)                                                      \
+        {                                                                                                                \
+            assert(pool->count + 1 <= pool->capacity);                                                                   \
+        }                                                                                                                \
+                                                                                                                         \
+        if (pool->count >= pool->capacity)                                                                               \
+        {                                                                                                                \
+            if ((pool->flags & POOL_FLAGS_EXPAND) == POOL_FLAGS_EXPAND)                                                  \
+            {                                                                                                            \
+                name##_pool_reserve(pool, pool->capacity * 2);                                                           \
+            }                                                                                                            \
+            else if ((pool->flags & POOL_FLAGS_RECYCLE) == POOL_FLAGS_RECYCLE)                                           \
+            {                                                                                                            \
+                name##_pool_remove(pool, pool->slots[pool->oldest].index);                                               \
+            }                                                                                                            \
+            else                                                                                                         \
+            {                                                                                                            \
+                return POOL_HANDLE_NONE;                                                                                 \
+            }                                                                                                            \
+        }                                                                                                                \
+                                                                                                                         \
+        uint32_t      index  = (uint32_t)pool->count++;                                                                  \
+        pool_handle_t handle = pool->handles[index];                                                                     \
+        uint32_t      slot   = pool_handle_slot(handle);                                                                 \
+                                                                                                                         \
+        pool->slots[slot].index = index;                                                                                 \
+        pool->data[index]       = item;                                                                                  \
+                                                                                                                         \
+        if ((pool->flags & POOL_FLAGS_RECYCLE) == POOL_FLAGS_RECYCLE)                                                    \
+        {                                                                                                                \
+            pool_order_link(pool->slots, &pool->oldest, &pool->newest, slot);                                            \
+        }                                                                                                                \
+                                                                                                                         \
+        return handle;                                                                                                   \
+    }                                                                                                                    \
+                                                                                                                         \
+    void name##_pool_remove(name##_pool_t* pool, uint32_t index)                                                         \
+    {                                                                                                                    \
+        assert(index < pool->count);                                                                                     \
+                                                                                                                         \
+        uint32_t slot = pool_handle_slot(pool->handles[index]);                                                          \
+        uint32_t last = (uint32_t)--pool->count;                                                                         \
+                                                                                                                         \
+        if ((pool->flags & POOL_FLAGS_RECYCLE) == POOL_FLAGS_RECYCLE)                                                    \
+        {                                                                                                                \
+            pool_order_unlink(pool->slots, &pool->oldest, &pool->newest, slot);                                          \
+        }                                                                                                                \
+                                                                                                                         \
+        if (index != last)                                                                                               \
+        {                                                                                                                \
+            pool->data[index]    = pool->data[last];                                                                     \
+            pool->handles[index] = pool->handles[last];                                                                  \
+                                                                                                                         \
+            pool->slots[pool_handle_slot(pool->handles[index])].index = index;                                           \
+        }                                                                                                                \
+                                                                                                                         \
+        pool->handles[last] = pool_slot_release(pool->slots, slot);                                                      \
+    }                                                                                                                    \
+                                                                                                                         \
+    bool name##_pool_remove_handle(name##_pool_t* pool, pool_handle_t handle)                                            \
+    {                                                                                                                    \
+        if (name##_pool_get(pool, handle) == NULL) return false;                                                         \
+                                                                                                                         \
+        name##_pool_remove(pool, pool->slots[pool_handle_slot(handle)].index);                                           \
+                                                                                                                         \
+        return true;                                                                                                     \
+    }                                                                                                                    \
+                                                                                                                         \
+    type* name##_pool_get(name##_pool_t* pool, pool_handle_t handle)                                                     \
+    {                                                                                                                    \
+        uint32_t slot = pool_handle_slot(handle);                                                                        \
+                                                                                                                         \
+        if (slot >= pool->capacity || pool->slots[slot].generation != pool_handle_generation(handle)) return NULL;       \
+                                                                                                                         \
+        return &pool->data[pool->slots[slot].index];                                                                     \
+    }                                                                                                                    \
+                                                                                                                         \
+    type* name##_pool_at(name##_pool_t* pool, pool_handle_t handle)                                                      \
+    {                                                                                                                    \
+        assert(name##_pool_get(pool, handle) != NULL);                                                                   \
+                                                                                                                         \
+        return &pool->data[pool->slots[pool_handle_slot(handle)].index];                                                 \
+    }                                                                                                                    \
+                                                                                                                         \
+    pool_handle_t name##_pool_handle(name##_pool_t* pool, uint32_t index)                                                \
+    {                                                                                                                    \
+        assert(index < pool->count);                                                                                     \
+                                                                                                                         \
+        return pool->handles[index];                                                                                     \
+    }                                                                                                                    \
+                                                                                                                         \
+    type* name##_pool_begin(name##_pool_t* pool) { return &pool->data[0]; }                                              \
+                                                                                                                         \
+    type* name##_pool_end(name##_pool_t* pool) { return &pool->data[pool->count]; }                                      \
+                                                                                                                         \
+    size_t name##_pool_count(name##_pool_t* pool) { return pool->count; }
+
+#define POOL_LOOP_FORWARD(type, name, pool, var) for (type* var = name##_pool_begin(pool); var != name##_pool_end(pool); ++var)
+#define POOL_LOOP_REVERSE(type, name, pool, var) for (type* var = name##_pool_end(pool) - 1; var >= name##_pool_begin(pool); --var)
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,230 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______   ______   __   __  ______   __  __     //
+//  /\  == \ /\  ___\ /\ "-.\ \/\  ___\ /\ \_\ \    //
+//  \ \  __< \ \  __\ \ \ \-.  \ \ \____\ \  __ \   //
+//   \ \_____\\ \_____\\ \_\\"\_\ \_____\\ \_\ \_\  //
+//    \/_____/ \/_____/ \/_/ \/_/\/_____/ \/_/\/_/  //
+//                                                  //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// tests/bench.c
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "utils/pool.h"
+
+// the game's pattern, a burst of inserts each frame, one pass
+// moving everything and a reverse pass removing what expired,
+// lives are short enough that the pool settles below capacity
+#define BENCH_CAPACITY (4096)
+#define BENCH_FRAMES   (20000)
+#define BENCH_BURST    (64)
+#define BENCH_LIFE     (30)
+
+typedef struct particle_t
+{
+    float    x, y;
+    float    vx, vy;
+    float    angle;
+    float    scale;
+    uint32_t color;
+    int      life;
+} particle_t;
+
+// the pool as it was before instances, one static per type
+// with a ring start, kept as the baseline, its functions are
+// external like the original so neither side gets inlined
+#define STATIC_POOL_DEFINE(type, name)                                                              \
+    static struct                                                                                   \
+    {                                                                                               \
+        uint32_t flags;                                                                             \
+                                                                                                    \
+        type* data;                                                                                 \
+                                                                                                    \
+        size_t start;                                                                               \
+        size_t count;                                                                               \
+        size_t capacity;                                                                            \
+    } name##_pool;                                                                                  \
+                                                                                                    \
+    void name##_pool_new(size_t capacity, uint32_t flags)                                           \
+    {                                                                                               \
+        name##_pool.data     = (type*)malloc(capacity * sizeof(type));                              \
+        name##_pool.start    = 0;                                                                   \
+        name##_pool.count    = 0;                                                                   \
+        name##_pool.capacity = capacity;                                                            \
+        name##_pool.flags    = flags;                                                               \
+                                                                                                    \
+        assert(name##_pool.data != NULL);                                                           \
+    }                                                                                               \
+                                                                                                    \
+    void name##_pool_delete(void) { free(name##_pool.data); }                                       \
+                                                                                                    \
+    void name##_pool_insert(type item)                                                              \
+    {                                                                                               \
+        if (name##_pool.count >= name##_pool.capacity)                                              \
+        {                                                                                           \
+            if ((name##_pool.flags & POOL_FLAGS_RECYCLE) == POOL_FLAGS_RECYCLE)                     \
+            {                                                                                       \
+                name##_pool.data[name##_pool.start] = item;                                         \
+                name##_pool.start                   = (name##_pool.start + 1) % name##_pool.count;  \
+            }                                                                                       \
+                                                                                                    \
+            return;                                                                                 \
+        }                                                                                           \
+                                                                                                    \
+        name##_pool.data[name##_pool.count++] = item;                                               \
+    }                                                                                               \
+                                                                                                    \
+    void name##_pool_remove(uint32_t index)                                                         \
+    {                                                                                               \
+        assert(name##_pool.count > 0);                                                              \
+                                                                                                    \
+        name##_pool.data[index] = name##_pool.data[name##_pool.count - 1];                          \
+        --name##_pool.count;                                                                        \
+    }                                                                                               \
+                                                                                                    \
+    type* name##_pool_begin(void) { return &name##_pool.data[0]; }                                  \
+                                                                                                    \
+    type* name##_pool_end(void) { return &name##_pool.data[name##_pool.count]; }
+
+STATIC_POOL_DEFINE(particle_t, statics)
+
+POOL_DECLARE(particle_t, particles)
+POOL_DEFINE(particle_t, particles)
+
+typedef struct bench_t
+{
+    double insert;
+    double iterate;
+    double remove;
+    size_t inserts;
+    size_t iterations;
+    size_t removes;
+} bench_t;
+
+static double bench_now(void)
+{
+    struct timespec now;
+
+    timespec_get(&now, TIME_UTC);
+
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static particle_t bench_particle(int frame, int i)
+{
+    return (particle_t){(float)i, (float)frame, 1.0f, -1.0f, 0.0f, 1.0f, 0xFFFFFFFF, BENCH_LIFE + (frame + i) % BENCH_LIFE};
+}
+
+static void bench_move(particle_t* particle)
+{
+    particle->x += particle->vx;
+    particle->y += particle->vy;
+    particle->angle += 0.1f;
+    particle->scale *= 0.99f;
+    particle->life -= 1;
+}
+
+static bench_t bench_static(void)
+{
+    bench_t bench = {0};
+
+    statics_pool_new(BENCH_CAPACITY, POOL_FLAGS_RECYCLE);
+
+    for (int frame = 0; frame < BENCH_FRAMES; ++frame)
+    {
+        double start = bench_now();
+
+        for (int i = 0; i < BENCH_BURST; ++i) statics_pool_insert(bench_particle(frame, i));
+
+        double moved = bench_now();
+
+        for (particle_t* particle = statics_pool_begin(); particle != statics_pool_end(); ++particle) bench_move(particle);
+
+        double removing = bench_now();
+
+        bench.iterations += statics_pool.count;
+
+        for (particle_t* particle = statics_pool_end() - 1; particle >= statics_pool_begin(); --particle)
+        {
+            if (particle->life > 0) continue;
+
+            statics_pool_remove((uint32_t)(particle - statics_pool_begin()));
+            ++bench.removes;
+        }
+
+        double end = bench_now();
+
+        bench.insert += moved - start;
+        bench.iterate += removing - moved;
+        bench.remove += end - removing;
+        bench.inserts += BENCH_BURST;
+    }
+
+    statics_pool_delete();
+
+    return bench;
+}
+
+static bench_t bench_instance(void)
+{
+    bench_t bench = {0};
+
+    particles_pool_t pool;
+
+    particles_pool_new(&pool, BENCH_CAPACITY, POOL_FLAGS_RECYCLE);
+
+    for (int frame = 0; frame < BENCH_FRAMES; ++frame)
+    {
+        double start = bench_now();
+
+        for (int i = 0; i < BENCH_BURST; ++i) particles_pool_insert(&pool, bench_particle(frame, i));
+
+        double moved = bench_now();
+
+        POOL_LOOP_FORWARD(particle_t, particles, &pool, particle) bench_move(particle);
+
+        double removing = bench_now();
+
+        bench.iterations += particles_pool_count(&pool);
+
+        POOL_LOOP_REVERSE(particle_t, particles, &pool, particle)
+        {
+            if (particle->life > 0) continue;
+
+            particles_pool_remove(&pool, (uint32_t)(particle - particles_pool_begin(&pool)));
+            ++bench.removes;
+        }
+
+        double end = bench_now();
+
+        bench.insert += moved - start;
+        bench.iterate += removing - moved;
+        bench.remove += end - removing;
+        bench.inserts += BENCH_BURST;
+    }
+
+    particles_pool_delete(&pool);
+
+    return bench;
+}
+
+static void bench_report(const char* name, bench_t bench)
+{
+    printf("    %-8s insert %6.2f ns  iterate %6.2f ns  remove %6.2f ns\n",
+           name,
+           bench.insert * 1e9 / (double)bench.inserts,
+           bench.iterate * 1e9 / (double)bench.iterations,
+           bench.remove * 1e9 / (double)(bench.removes ? bench.removes : 1));
+}
+
+int main(void)
+{
+    printf("    %d frames of %d inserts, %d capacity, per item, remove includes its pass\n", BENCH_FRAMES, BENCH_BURST, BENCH_CAPACITY);
+
+    bench_report("static", bench_static());
+    bench_report("instance", bench_instance());
+
+    return 0;
+}
@@ -0,0 +1,287 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______  ______   ______   __         //
+//  /\  == \/\  __ \ /\  __ \ /\ \        //
+//  \ \  _-/\ \ \/\ \\ \ \/\ \\ \ \____   //
+//   \ \_\   \ \_____\\ \_____\\ \_____\  //
+//    \/_/    \/_____/ \/_____/ \/_____/  //
+//                                        //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// tests/pool.c
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "utils/pool.h"
+
+// failures are counted instead of asserted,
+// so one run reports every broken case
+#define TEST_CHECK(cond)                                                   \
+    do                                                                     \
+    {                                                                      \
+        ++tests_run;                                                       \
+        if (!(cond))                                                       \
+        {                                                                  \
+            ++tests_failed;                                                \
+            fprintf(stderr, "    %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        }                                                                  \
+    } while (0)
+
+static int tests_run;
+static int tests_failed;
+
+typedef struct item_t
+{
+    int   value;
+    float weight;
+} item_t;
+
+typedef struct wide_t
+{
+    char bytes[24];
+} wide_t;
+
+POOL_DECLARE(item_t, items)
+POOL_DEFINE(item_t, items)
+
+POOL_DECLARE(wide_t, wides)
+POOL_DEFINE(wide_t, wides)
+
+static bool test_aligned(const void* data) { return ((uintptr_t)data & (POOL_ALIGNMENT - 1)) == 0; }
+
+static int test_sum(items_pool_t* pool)
+{
+    int sum = 0;
+
+    POOL_LOOP_FORWARD(item_t, items, pool, item) sum += item->value;
+
+    return sum;
+}
+
+static void test_insert_remove(void)
+{
+    items_pool_t pool;
+
+    items_pool_new(&pool, 4, POOL_FLAGS_NONE);
+
+    pool_handle_t handles[4];
+
+    for (int i = 0; i < 4; ++i) handles[i] = items_pool_insert(&pool, (item_t){i + 1, 0.0f});
+
+    TEST_CHECK(items_pool_count(&pool) == 4);
+    TEST_CHECK(test_sum(&pool) == 10);
+    TEST_CHECK(items_pool_insert(&pool, (item_t){5, 0.0f}) == POOL_HANDLE_NONE);
+
+    // the last item moves into the hole,
+    // its handle follows it there
+    items_pool_remove(&pool, 0);
+
+    TEST_CHECK(items_pool_count(&pool) == 3);
+    TEST_CHECK(items_pool_begin(&pool)->value == 4);
+    TEST_CHECK(items_pool_get(&pool, handles[0]) == NULL);
+    TEST_CHECK(items_pool_at(&pool, handles[3]) == items_pool_begin(&pool));
+    TEST_CHECK(items_pool_handle(&pool, 0) == handles[3]);
+
+    TEST_CHECK(items_pool_remove_handle(&pool, handles[1]));
+
+    TEST_CHECK(items_pool_count(&pool) == 2);
+
+    // a stale handle's slot is free or given out again,
+    // removing through it must leave the items alone
+    TEST_CHECK(!items_pool_remove_handle(&pool, handles[1]));
+    TEST_CHECK(!items_pool_remove_handle(&pool, handles[0]));
+    TEST_CHECK(items_pool_count(&pool) == 2);
+    TEST_CHECK(test_sum(&pool) == 7);
+    TEST_CHECK(items_pool_at(&pool, handles[2])->value == 3);
+
+    // a reused slot doesn't bring its old handles back
+    pool_handle_t handle = items_pool_insert(&pool, (item_t){6, 0.0f});
+
+    TEST_CHECK(handle != handles[1]);
+    TEST_CHECK(items_pool_get(&pool, handles[1]) == NULL);
+    TEST_CHECK(items_pool_at(&pool, handle)->value == 6);
+
+    POOL_LOOP_REVERSE(item_t, items, &pool, item)
+    {
+        if (item->value % 2 == 0) items_pool_remove(&pool, (uint32_t)(item - items_pool_begin(&pool)));
+    }
+
+    TEST_CHECK(items_pool_count(&pool) == 1);
+    TEST_CHECK(items_pool_begin(&pool)->value == 3);
+
+    items_pool_delete(&pool);
+}
+
+static void test_reserve(void)
+{
+    items_pool_t pool;
+
+    items_pool_new(&pool, 2, POOL_FLAGS_EXPAND);
+
+    pool_handle_t handles[100];
+
+    for (int i = 0; i < 100; ++i)
+    {
+        handles[i] = items_pool_insert(&pool, (item_t){i, (float)i});
+
+        TEST_CHECK(test_aligned(items_pool_begin(&pool)));
+    }
+
+    TEST_CHECK(pool.capacity == 128);
+    TEST_CHECK(test_sum(&pool) == 4950);
+
+    bool found = true;
+
+    for (int i = 0; i < 100; ++i) found = found && items_pool_at(&pool, handles[i])->value == i;
+
+    TEST_CHECK(found);
+
+    items_pool_reserve(&pool, 64);
+
+    TEST_CHECK(pool.capacity == 128);
+
+    items_pool_delete(&pool);
+}
+
+// the static pool copied out of a wrapped ring on reserve, the
+// packed data has no wrap but the eviction order must survive
+static void test_reserve_recycled(void)
+{
+    items_pool_t pool;
+
+    items_pool_new(&pool, 4, POOL_FLAGS_RECYCLE);
+
+    pool_handle_t handles[10];
+
+    for (int i = 0; i < 6; ++i) handles[i] = items_pool_insert(&pool, (item_t){i, 0.0f});
+
+    TEST_CHECK(items_pool_count(&pool) == 4);
+    TEST_CHECK(items_pool_get(&pool, handles[0]) == NULL);
+    TEST_CHECK(items_pool_get(&pool, handles[1]) == NULL);
+    TEST_CHECK(test_sum(&pool) == 2 + 3 + 4 + 5);
+
+    // oldest first even after a remove shuffled the data
+    items_pool_remove_handle(&pool, handles[2]);
+    handles[6] = items_pool_insert(&pool, (item_t){6, 0.0f});
+    handles[7] = items_pool_insert(&pool, (item_t){7, 0.0f});
+
+    TEST_CHECK(items_pool_get(&pool, handles[3]) == NULL);
+    TEST_CHECK(items_pool_at(&pool, handles[4])->value == 4);
+
+    items_pool_reserve(&pool, 6);
+
+    TEST_CHECK(test_aligned(items_pool_begin(&pool)));
+    TEST_CHECK(test_sum(&pool) == 4 + 5 + 6 + 7);
+
+    handles[8] = items_pool_insert(&pool, (item_t){8, 0.0f});
+    handles[9] = items_pool_insert(&pool, (item_t){9, 0.0f});
+
+    TEST_CHECK(items_pool_count(&pool) == 6);
+
+    items_pool_insert(&pool, (item_t){10, 0.0f});
+
+    TEST_CHECK(items_pool_get(&pool, handles[4]) == NULL);
+    TEST_CHECK(items_pool_at(&pool, handles[5])->value == 5);
+    TEST_CHECK(test_sum(&pool) == 5 + 6 + 7 + 8 + 9 + 10);
+
+    items_pool_delete(&pool);
+}
+
+static void test_alignment(void)
+{
+    wides_pool_t pool;
+
+    // odd sized items and a run of reallocs, the
+    // data has to land on a line after every one
+    wides_pool_new(&pool, 3, POOL_FLAGS_EXPAND);
+
+    TEST_CHECK(test_aligned(wides_pool_begin(&pool)));
+
+    bool aligned = true;
+    bool kept    = true;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        wide_t wide;
+
+        memset(wide.bytes, i & 0xFF, sizeof(wide.bytes));
+
+        wides_pool_insert(&pool, wide);
+
+        aligned = aligned && test_aligned(wides_pool_begin(&pool));
+    }
+
+    for (int i = 0; i < 1000; ++i) kept = kept && (unsigned char)wides_pool_begin(&pool)[i].bytes[23] == (i & 0xFF);
+
+    TEST_CHECK(aligned);
+    TEST_CHECK(kept);
+
+    wides_pool_delete(&pool);
+}
+
+static void test_clear(void)
+{
+    items_pool_t pool;
+
+    items_pool_new(&pool, 3, POOL_FLAGS_RECYCLE);
+
+    pool_handle_t first = items_pool_insert(&pool, (item_t){1, 0.0f});
+
+    items_pool_insert(&pool, (item_t){2, 0.0f});
+    items_pool_clear(&pool);
+
+    TEST_CHECK(items_pool_count(&pool) == 0);
+    TEST_CHECK(items_pool_begin(&pool) == items_pool_end(&pool));
+    TEST_CHECK(items_pool_get(&pool, first) == NULL);
+    TEST_CHECK(pool.capacity == 3);
+
+    // eviction starts over with what came after the clear
+    for (int i = 0; i < 4; ++i) items_pool_insert(&pool, (item_t){10 + i, 0.0f});
+
+    TEST_CHECK(test_sum(&pool) == 11 + 12 + 13);
+
+    items_pool_delete(&pool);
+
+    TEST_CHECK(pool.data == NULL && pool.count == 0 && pool.oldest == POOL_SLOT_NONE);
+}
+
+static void test_independent(void)
+{
+    items_pool_t a;
+    items_pool_t b;
+
+    items_pool_new(&a, 2, POOL_FLAGS_NONE);
+    items_pool_new(&b, 2, POOL_FLAGS_EXPAND);
+
+    pool_handle_t handle_a = items_pool_insert(&a, (item_t){1, 0.0f});
+    pool_handle_t handle_b = items_pool_insert(&b, (item_t){2, 0.0f});
+
+    for (int i = 0; i < 10; ++i) items_pool_insert(&b, (item_t){3, 0.0f});
+
+    TEST_CHECK(items_pool_count(&a) == 1);
+    TEST_CHECK(items_pool_count(&b) == 11);
+    TEST_CHECK(items_pool_at(&a, handle_a)->value == 1);
+    TEST_CHECK(items_pool_at(&b, handle_b)->value == 2);
+
+    items_pool_clear(&b);
+
+    TEST_CHECK(items_pool_count(&a) == 1);
+    TEST_CHECK(items_pool_at(&a, handle_a)->value == 1);
+
+    items_pool_delete(&a);
+    items_pool_delete(&b);
+}
+
+int main(void)
+{
+    test_insert_remove();
+    test_reserve();
+    test_reserve_recycled();
+    test_alignment();
+    test_clear();
+    test_independent();
+
+    printf("    pool: %d checks, %d failed\n", tests_run, tests_failed);
+
+    return tests_failed ? 1 : 0;
+}
@@ -0,0 +1,230 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   __    __   __   __  __   ______   ______     //
+//  /\ "-./  \ /\ \ /\_\_\_\ /\  ___\ /\  == \    //
+//  \ \ \-./\ \\ \ \\/_/\_\/_\ \  __\ \ \  __<    //
+//   \ \_\ \ \_\\ \_\/\_\/\_\ \ \_____\\ \_\ \_\  //
+//    \/_/  \/_/ \/_/\/_/\/_/  \/_____/ \/_/ /_/  //
+//                                                //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// tools/mixer.c
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SDL_MAIN_HANDLED
+
+#define CUTE_SOUND_FORCE_SDL
+#define CUTE_SOUND_IMPLEMENTATION
+
+// the same switch as audio.c, so hosts
+// without sse2 only ever measure scalar
+#if !defined(CUTE_SOUND_SCALAR_MODE) && !defined(__SSE2__) && !defined(_M_X64) && !(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CUTE_SOUND_SCALAR_MODE
+#endif
+
+#define CUTE_SOUND_SDL_H "SDL.h"
+#include "SDL.h"
+#include "audio/headless.h"
+#include "cute_sound.h"
+
+#define MIXER_RATE       (44100)
+#define MIXER_BLOCK      (512)
+#define MIXER_WAV_HEADER (44)
+#define MIXER_TOLERANCE  (2)
+
+#define MIXER_PI (3.14159265358979323846)
+
+static void mixer_write_u16(uint8_t* out, uint16_t value) { memcpy(out, &value, sizeof(value)); }
+static void mixer_write_u32(uint8_t* out, uint32_t value) { memcpy(out, &value, sizeof(value)); }
+
+// a second of stereo sine, whole cycles
+// so the looped voices don't click
+static uint8_t* mixer_make_wav(int frequency, size_t* size)
+{
+    uint32_t data_size = MIXER_RATE * 4;
+
+    *size = MIXER_WAV_HEADER + data_size;
+
+    uint8_t* wav = (uint8_t*)malloc(*size);
+
+    if (wav == NULL) return NULL;
+
+    memcpy(wav, "RIFF", 4);
+    mixer_write_u32(wav + 4, 36 + data_size);
+    memcpy(wav + 8, "WAVEfmt ", 8);
+    mixer_write_u32(wav + 16, 16);
+    mixer_write_u16(wav + 20, 1);
+    mixer_write_u16(wav + 22, 2);
+    mixer_write_u32(wav + 24, MIXER_RATE);
+    mixer_write_u32(wav + 28, MIXER_RATE * 4);
+    mixer_write_u16(wav + 32, 4);
+    mixer_write_u16(wav + 34, 16);
+    memcpy(wav + 36, "data", 4);
+    mixer_write_u32(wav + 40, data_size);
+
+    int16_t* samples = (int16_t*)(wav + MIXER_WAV_HEADER);
+
+    for (int i = 0; i < MIXER_RATE; ++i)
+    {
+        double phase = 2.0 * MIXER_PI * frequency * i / MIXER_RATE;
+
+        samples[i * 2 + 0] = (int16_t)(8000.0 * sin(phase));
+        samples[i * 2 + 1] = (int16_t)(8000.0 * cos(phase));
+    }
+
+    return wav;
+}
+
+// the two builds differ in float rounding only,
+// anything past a couple of steps is a real bug
+static int mixer_compare(const char* a, const char* b, int tolerance)
+{
+    FILE* fa = fopen(a, "rb");
+    FILE* fb = fopen(b, "rb");
+
+    if (fa == NULL || fb == NULL)
+    {
+        fprintf(stderr, "failed to open \"%s\"\n", fa == NULL ? a : b);
+        return 1;
+    }
+
+    int16_t  sa, sb;
+    int      worst    = 0;
+    uint64_t count    = 0;
+    uint64_t mismatch = 0;
+
+    while (fread(&sa, sizeof(int16_t), 1, fa) == 1)
+    {
+        if (fread(&sb, sizeof(int16_t), 1, fb) != 1)
+        {
+            fprintf(stderr, "\"%s\" is shorter\n", b);
+            return 1;
+        }
+
+        int diff = abs((int)sa - (int)sb);
+
+        if (diff > worst) worst = diff;
+        if (diff > tolerance) ++mismatch;
+
+        ++count;
+    }
+
+    bool longer = fread(&sb, sizeof(int16_t), 1, fb) == 1;
+
+    fclose(fa);
+    fclose(fb);
+
+    if (longer)
+    {
+        fprintf(stderr, "\"%s\" is longer\n", b);
+        return 1;
+    }
+
+    printf("    %llu samples, max difference %d, %llu over %d\n", (unsigned long long)count, worst, (unsigned long long)mismatch, tolerance);
+
+    return mismatch ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc >= 4 && strcmp(argv[1], "--compare") == 0) return mixer_compare(argv[2], argv[3], argc > 4 ? atoi(argv[4]) : MIXER_TOLERANCE);
+
+    if (argc != 4 || atoi(argv[1]) <= 0 || atof(argv[2]) <= 0.0)
+    {
+        fprintf(stderr, "usage: mixer <voices> <seconds> <output>\n");
+        fprintf(stderr, "       mixer --compare <a> <b> [<tolerance>]\n");
+        return 1;
+    }
+
+    int    voices  = atoi(argv[1]);
+    double seconds = atof(argv[2]);
+
+    FILE* out = fopen(argv[3], "wb");
+
+    if (out == NULL)
+    {
+        fprintf(stderr, "failed to open \"%s\"\n", argv[3]);
+        return 1;
+    }
+
+    SDL_SetHint(SDL_HINT_AUDIODRIVER, "dummy");
+    SDL_InitSubSystem(SDL_INIT_AUDIO);
+
+    headless_enable(true);
+
+    if (cs_init(NULL, MIXER_RATE, MIXER_BLOCK, NULL) != CUTE_SOUND_ERROR_NONE)
+    {
+        fprintf(stderr, "failed to start cute_sound\n");
+        return 1;
+    }
+
+    cs_audio_source_t** sources = (cs_audio_source_t**)calloc((size_t)voices, sizeof(cs_audio_source_t*));
+
+    for (int i = 0; i < voices; ++i)
+    {
+        size_t   size;
+        uint8_t* wav = mixer_make_wav(110 * (1 + i % 8), &size);
+
+        sources[i] = cs_read_mem_wav(wav, size, NULL);
+
+        free(wav);
+
+        cs_sound_params_t params = cs_sound_params_default();
+
+        params.looped = true;
+        params.volume = 0.25f + 0.25f * (float)(i % 4);
+        params.pan    = (float)(i % 5) / 4.0f;
+
+        cs_play_sound(sources[i], params);
+    }
+
+    int16_t  block[MIXER_BLOCK * 2];
+    uint64_t frames = (uint64_t)(seconds * MIXER_RATE);
+    uint64_t ticks  = 0;
+
+    for (uint64_t frame = 0; frame < frames; frame += MIXER_BLOCK)
+    {
+        int len = frames - frame < MIXER_BLOCK ? (int)(frames - frame) : MIXER_BLOCK;
+
+        uint64_t start = SDL_GetPerformanceCounter();
+
+        cs_update((float)len / MIXER_RATE);
+
+        ticks += SDL_GetPerformanceCounter() - start;
+
+        headless_pull(block, len);
+
+        fwrite(block, sizeof(int16_t), (size_t)len * 2, out);
+    }
+
+    fclose(out);
+
+    cs_stop_all_playing_sounds();
+
+    for (int i = 0; i < voices; ++i) cs_free_audio_source(sources[i]);
+
+    free(sources);
+
+    cs_shutdown();
+
+    headless_enable(false);
+
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+
+    double mixed = (double)ticks / (double)SDL_GetPerformanceFrequency();
+
+#ifdef CUTE_SOUND_SCALAR_MODE
+    const char* mode = "scalar";
+#else
+    const char* mode = "sse2";
+#endif
+
+    printf("    %s, %d voices for %.1f s mixed in %.3f ms\n", mode, voices, seconds, mixed * 1000.0);
+    printf("    %.3f us per voice per second, %.0fx realtime\n", mixed * 1e6 / (voices * seconds), seconds / mixed);
+
+    return 0;
+}
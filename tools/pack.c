@@ -0,0 +1,313 @@
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+//   ______   ______   ______   __  __     //
+//  /\  == \ /\  __ \ /\  ___\ /\ \/ /     //
+//  \ \  _-/ \ \  __ \\ \ \____\ \  _"-.   //
+//   \ \_\    \ \_\ \_\\ \_____\\ \_\ \_\  //
+//    \/_/     \/_/\/_/ \/_____/ \/_/\/_/  //
+//                                         //
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ //
+// tools/pack.c
+
+#include <dirent.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "platform/pack.h"
+
+#define PACK_MAX_FILES (4096)
+#define PACK_MAX_PATH  (1024)
+
+#define LZ4_HASH_BITS  (12)
+#define LZ4_MIN_MATCH  (4)
+#define LZ4_LAST_BYTES (5)
+#define LZ4_MATCH_END  (12)
+
+typedef struct
+{
+    char     name[PACK_MAX_PATH];
+    uint8_t* data;
+    uint32_t size;
+    uint32_t packed_size;
+} pack_file_t;
+
+static pack_file_t files[PACK_MAX_FILES];
+static size_t      files_len;
+
+static int pack_compare_name(const void* a, const void* b) { return strcmp(((pack_file_t*)a)->name, ((pack_file_t*)b)->name); }
+
+static uint32_t lz4_read32(const uint8_t* src)
+{
+    uint32_t value;
+    memcpy(&value, src, sizeof(value));
+    return value;
+}
+
+static uint8_t* lz4_write_length(uint8_t* out, size_t len)
+{
+    for (; len >= 255; len -= 255) *out++ = 255;
+    *out++ = (uint8_t)len;
+    return out;
+}
+
+static uint8_t* lz4_emit(uint8_t* out, const uint8_t* literals, size_t literals_len, size_t offset, size_t match_len)
+{
+    uint8_t* token = out++;
+
+    *token = (uint8_t)((literals_len < 15 ? literals_len : 15) << 4);
+
+    if (literals_len >= 15) out = lz4_write_length(out, literals_len - 15);
+
+    memcpy(out, literals, literals_len);
+    out += literals_len;
+
+    // the last sequence carries literals only
+    if (match_len == 0) return out;
+
+    *out++ = (uint8_t)(offset & 0xFF);
+    *out++ = (uint8_t)(offset >> 8);
+
+    size_t match = match_len - LZ4_MIN_MATCH;
+
+    *token |= (uint8_t)(match < 15 ? match : 15);
+
+    if (match >= 15) out = lz4_write_length(out, match - 15);
+
+    return out;
+}
+
+static size_t lz4_compress(const uint8_t* src, size_t len, uint8_t* dst)
+{
+    static uint32_t table[1 << LZ4_HASH_BITS];
+
+    memset(table, 0, sizeof(table));
+
+    uint8_t* out    = dst;
+    size_t   anchor = 0;
+    size_t   i      = 0;
+
+    // greedy matching on a single hash table, the format
+    // wants the last bytes of a block kept as literals
+    while (len > LZ4_MATCH_END && i < len - LZ4_MATCH_END)
+    {
+        uint32_t sequence  = lz4_read32(src + i);
+        uint32_t hash      = (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+        size_t   candidate = table[hash];
+
+        table[hash] = (uint32_t)(i + 1);
+
+        if (candidate == 0 || i - (candidate - 1) > 0xFFFF || lz4_read32(src + candidate - 1) != sequence)
+        {
+            ++i;
+            continue;
+        }
+
+        size_t reference = candidate - 1;
+        size_t match_len = LZ4_MIN_MATCH;
+
+        while (i + match_len < len - LZ4_LAST_BYTES && src[reference + match_len] == src[i + match_len]) ++match_len;
+
+        out = lz4_emit(out, src + anchor, i - anchor, i - reference, match_len);
+
+        i += match_len;
+        anchor = i;
+    }
+
+    out = lz4_emit(out, src + anchor, len - anchor, 0, 0);
+
+    return (size_t)(out - dst);
+}
+
+static void pack_collect(const char* root, const char* relative)
+{
+    char path[PACK_MAX_PATH];
+
+    snprintf(path, sizeof(path), "%s%s%s", root, *relative ? "/" : "", relative);
+
+    DIR* dir = opendir(path);
+
+    if (dir == NULL) return;
+
+    struct dirent* entry;
+
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] == '.') continue;
+
+        char name[PACK_MAX_PATH];
+        char filepath[PACK_MAX_PATH * 2];
+
+        snprintf(name, sizeof(name), "%s%s%s", relative, *relative ? "/" : "", entry->d_name);
+        snprintf(filepath, sizeof(filepath), "%s/%s", root, name);
+
+        struct stat status;
+
+        if (stat(filepath, &status) != 0) continue;
+
+        if (S_ISDIR(status.st_mode))
+        {
+            pack_collect(root, name);
+            continue;
+        }
+
+        if (files_len == PACK_MAX_FILES)
+        {
+            fprintf(stderr, "too many files, skipping \"%s\"\n", name);
+            continue;
+        }
+
+        FILE* file = fopen(filepath, "rb");
+
+        if (file == NULL) continue;
+
+        pack_file_t* pack_file = &files[files_len++];
+
+        strcpy(pack_file->name, name);
+
+        pack_file->size = (uint32_t)status.st_size;
+        pack_file->data = (uint8_t*)malloc(pack_file->size + 1);
+
+        if (fread(pack_file->data, 1, pack_file->size, file) != pack_file->size) fprintf(stderr, "failed to read \"%s\"\n", name);
+
+        fclose(file);
+    }
+
+    closedir(dir);
+}
+
+// wavs are left stored so long tracks can
+// be streamed from the mapping as they play
+static bool pack_is_audio(const pack_file_t* file)
+{
+    size_t len = strlen(file->name);
+
+    return len >= 4 && strcmp(file->name + len - 4, ".wav") == 0;
+}
+
+static void pack_compress(pack_file_t* file)
+{
+    file->packed_size = file->size;
+
+    uint8_t* packed = (uint8_t*)malloc(file->size + file->size / 255 + 16);
+    size_t   len    = lz4_compress(file->data, file->size, packed);
+
+    // keep entries stored unless compression saves
+    // enough to be worth unpacking at load time
+    if (len < file->size - file->size / 8 && !pack_is_audio(file))
+    {
+        free(file->data);
+
+        file->data        = packed;
+        file->packed_size = (uint32_t)len;
+    }
+    else
+    {
+        free(packed);
+    }
+}
+
+static void pack_write_padding(FILE* out, long* offset)
+{
+    static const uint8_t zeros[PACK_ALIGNMENT];
+
+    long padding = (PACK_ALIGNMENT - *offset % PACK_ALIGNMENT) % PACK_ALIGNMENT;
+
+    fwrite(zeros, 1, padding, out);
+    *offset += padding;
+}
+
+int main(int argc, char** argv)
+{
+    bool compress = true;
+
+    if (argc > 1 && strcmp(argv[1], "-u") == 0)
+    {
+        compress = false;
+        ++argv;
+        --argc;
+    }
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: pack [-u] <directory> <output>\n");
+        return 1;
+    }
+
+    pack_collect(argv[1], "");
+
+    qsort(files, files_len, sizeof(pack_file_t), pack_compare_name);
+
+    uint32_t names_size = 0;
+
+    for (size_t i = 0; i < files_len; ++i)
+    {
+        names_size += (uint32_t)strlen(files[i].name) + 1;
+
+        if (compress) pack_compress(&files[i]);
+        else files[i].packed_size = files[i].size;
+    }
+
+    FILE* out = fopen(argv[2], "wb");
+
+    if (out == NULL)
+    {
+        fprintf(stderr, "failed to open \"%s\"\n", argv[2]);
+        return 1;
+    }
+
+    pack_header_t header = {
+        .magic       = PACK_MAGIC,
+        .version     = PACK_VERSION,
+        .entries_len = (uint32_t)files_len,
+        .names_size  = names_size,
+    };
+
+    long offset = (long)(sizeof(pack_header_t) + files_len * sizeof(pack_entry_t) + names_size);
+
+    offset += (PACK_ALIGNMENT - offset % PACK_ALIGNMENT) % PACK_ALIGNMENT;
+
+    fwrite(&header, sizeof(header), 1, out);
+
+    uint32_t name = 0;
+
+    for (size_t i = 0; i < files_len; ++i)
+    {
+        pack_entry_t entry = {
+            .name        = name,
+            .offset      = (uint32_t)offset,
+            .size        = files[i].size,
+            .packed_size = files[i].packed_size,
+        };
+
+        fwrite(&entry, sizeof(entry), 1, out);
+
+        name += (uint32_t)strlen(files[i].name) + 1;
+        offset += files[i].packed_size;
+        offset += (PACK_ALIGNMENT - offset % PACK_ALIGNMENT) % PACK_ALIGNMENT;
+    }
+
+    for (size_t i = 0; i < files_len; ++i) fwrite(files[i].name, 1, strlen(files[i].name) + 1, out);
+
+    offset = (long)(sizeof(pack_header_t) + files_len * sizeof(pack_entry_t) + names_size);
+
+    pack_write_padding(out, &offset);
+
+    for (size_t i = 0; i < files_len; ++i)
+    {
+        fwrite(files[i].data, 1, files[i].packed_size, out);
+
+        offset += files[i].packed_size;
+
+        pack_write_padding(out, &offset);
+
+        printf("    %-40s %8u -> %8u\n", files[i].name, files[i].size, files[i].packed_size);
+
+        free(files[i].data);
+    }
+
+    fclose(out);
+
+    return 0;
+}